@@ -0,0 +1,286 @@
+#include "adc.h"
+#include "config_bits.h"
+
+
+// Sample ring
+
+// Single producer (ADC interrupt) and single consumer (foreground).
+// Each side only ever writes its own index, and an 8-bit index is
+// updated in one instruction, so neither side needs to mask interrupts.
+#define ADC_RING_MASK (ADC_RING_SIZE - 1)
+
+static unsigned int adc_ring[ADC_RING_SIZE];
+static volatile unsigned char adc_head;     // written by ISR
+static volatile unsigned char adc_tail;     // written by main loop
+
+static volatile unsigned long adc_count;    // samples offered to the ring
+static volatile unsigned int adc_dropped;   // ring full, sample discarded
+
+
+// Scan state
+
+// adc_due has one bit per entry to convert in the current tick and
+// adc_cur is the entry whose conversion is in flight (adc_n when the
+// tick has nothing due). Everything here is only written by the ISR
+// once scanning runs.
+static const adc_scan_t *adc_tab;
+static unsigned char adc_n;
+static unsigned char adc_cur;
+static unsigned char adc_due;
+static unsigned char adc_chs;                   // CHS as last written
+static unsigned char adc_every[ADC_SCAN_MAX];   // convert every Nth tick
+static unsigned char adc_left[ADC_SCAN_MAX];    // ticks until the next one
+static unsigned int adc_tick_hz;                // as programmed
+
+// Per entry results. 64 conversions of at most 1023 still fit the
+// 16-bit sum; it starts at half a decimated step so the shift rounds
+// to nearest. adc_avg holds the average << ADC_AVG_SHIFT.
+static unsigned int adc_acc[ADC_SCAN_MAX];
+static unsigned char adc_acc_left[ADC_SCAN_MAX];
+static volatile unsigned int adc_latest[ADC_SCAN_MAX];
+static volatile unsigned int adc_avg[ADC_SCAN_MAX];
+static unsigned char adc_primed;                // bit per entry: adc_avg valid
+
+
+// Start scanning a table of channels
+
+// Timer3 counts Tcy (4 MHz) through the smallest prescaler that fits
+// the tick in 16 bits; CCP5 in special event mode resets it on CCPR5
+// and sets GO for the first entry due. Analogue pins must already be
+// configured through ANSELx by the caller.
+void ADC_Scan_Start(const adc_scan_t *table, unsigned char entries) {
+
+    unsigned long tick = 0, conv, counts;
+    unsigned char i, ps = 0;
+
+    if (entries == 0 || entries > ADC_SCAN_MAX) return;
+    ADC_Stop();
+
+    // The fastest entry sets the tick, the rest divide it
+    for (i = 0; i < entries; i++) {
+        conv = (unsigned long)table[i].rate_hz << (2 * table[i].extra_bits);
+        if (conv > tick) tick = conv;
+    }
+    if (tick == 0) return;
+    for (i = 0; i < entries; i++) {
+        conv = (unsigned long)table[i].rate_hz << (2 * table[i].extra_bits);
+        conv = conv ? (tick + conv / 2) / conv : 255;
+        adc_every[i] = (unsigned char)(conv > 255 ? 255 : conv);
+        adc_acc_left[i] = (unsigned char)(1u << (2 * table[i].extra_bits));
+        adc_acc[i] = table[i].extra_bits ? 1u << (table[i].extra_bits - 1) : 0;
+        adc_latest[i] = 0;
+        adc_avg[i] = 0;
+    }
+    adc_primed = 0;
+
+    counts = (_XTAL_FREQ / 4) / tick;
+    if (counts == 0) counts = 1;
+    while (counts > 65536UL && ps < 3) {     // 1:1, 1:2, 1:4, 1:8
+        counts >>= 1;
+        ps++;
+    }
+    if (counts > 65536UL) counts = 65536UL;  // slowest: about 7.6 Hz
+    adc_tick_hz = (unsigned int)(((_XTAL_FREQ / 4) >> ps) / counts);
+
+    adc_tab = table;
+    adc_n = entries;
+    adc_due = (unsigned char)((1u << entries) - 1);   // all due on the first tick
+    adc_cur = 0;
+    for (i = 0; i < entries; i++)
+        adc_left[i] = adc_every[i];
+
+    adc_head = 0;
+    adc_tail = 0;
+    adc_count = 0;
+    adc_dropped = 0;
+
+    // ADC: VDD/VSS references, trigger from CCP5
+    ADCON1 = 0x00;
+    ADCON2bits.ADFM = 1;      // Right-justified result
+    ADCON2bits.ACQT = 4;      // 8 TAD acquisition, started by hardware
+    ADCON2bits.ADCS = 2;      // Fosc/32: TAD = 2 us, 38 us per sample
+    adc_chs = table[0].channel;
+    ADCON0 = (unsigned char)(adc_chs << 2);
+    ADCON0bits.ADON = 1;
+
+    // Timer3 from Fosc/4, CCP5 special event on Timer3
+    T3CON = (unsigned char)(ps << 4);
+    TMR3H = 0;
+    TMR3L = 0;
+    CCPR5H = (unsigned char)((counts - 1) >> 8);
+    CCPR5L = (unsigned char)(counts - 1);
+    CCPTMRS1bits.C5TSEL = 1;
+    CCP5CON = 0x0B;
+
+    PIR1bits.ADIF = 0;
+    PIE1bits.ADIE = 1;
+    INTCONbits.PEIE = 1;
+    T3CONbits.TMR3ON = 1;
+}
+
+
+// Start sampling one channel into the ring
+
+void ADC_Start(unsigned char channel, unsigned int rate_hz, unsigned char extra_bits) {
+
+    static adc_scan_t single;
+
+    if (extra_bits > ADC_MAX_EXTRA_BITS) extra_bits = ADC_MAX_EXTRA_BITS;
+    ADC_Stop();                  // the ISR may still be reading 'single'
+    single.channel = channel;
+    single.extra_bits = extra_bits;
+    single.rate_hz = rate_hz;
+    single.done = ADC_Queue;
+    ADC_Scan_Start(&single, 1);
+}
+
+
+// Stop the trigger; results already taken stay readable
+
+void ADC_Stop(void) {
+    T3CONbits.TMR3ON = 0;
+    CCP5CON = 0x00;
+    PIE1bits.ADIE = 0;
+}
+
+
+// Fold one conversion into an entry's results
+
+// When oversampling, most conversions only add to the block sum; the
+// last one of a block decimates it into a sample.
+static void ADC_Store(unsigned char i, unsigned int v) {
+
+    unsigned char bits = adc_tab[i].extra_bits;
+
+    if (bits) {
+        adc_acc[i] += v;
+        if (--adc_acc_left[i])
+            return;
+        v = adc_acc[i] >> bits;
+        adc_acc[i] = 1u << (bits - 1);
+        adc_acc_left[i] = (unsigned char)(1u << (2 * bits));
+    }
+
+    adc_latest[i] = v;
+    if (adc_primed & (1u << i)) {
+        adc_avg[i] += v - (adc_avg[i] >> ADC_AVG_SHIFT);
+    } else {
+        adc_avg[i] = v << ADC_AVG_SHIFT;
+        adc_primed |= (unsigned char)(1u << i);
+    }
+    if (adc_tab[i].done)
+        adc_tab[i].done(v);
+}
+
+
+// ADC interrupt: store the result and start the next conversion
+
+// Entries due in this tick are converted one after another from here.
+// After the last one the next tick's due set is worked out and CHS is
+// left on its first entry for the CCP5 trigger to convert.
+void ADC_ISR_Handler(void) {
+
+    unsigned char i = adc_cur;
+
+    PIR1bits.ADIF = 0;
+    if (i < adc_n) {
+        ADC_Store(i, ((unsigned int)ADRESH << 8) | ADRESL);
+        while (++i < adc_n && !(adc_due & (1u << i)))
+            ;
+        if (i < adc_n) {                     // back-to-back, ACQT first
+            adc_cur = i;
+            adc_chs = adc_tab[i].channel;
+            ADCON0 = (unsigned char)((adc_chs << 2) | 0x01);
+            ADCON0bits.GO = 1;
+            return;
+        }
+    }
+
+    adc_due = 0;
+    for (i = 0; i < adc_n; i++) {
+        if (--adc_left[i] == 0) {
+            adc_left[i] = adc_every[i];
+            adc_due |= (unsigned char)(1u << i);
+        }
+    }
+    for (i = 0; i < adc_n && !(adc_due & (1u << i)); i++)
+        ;
+    adc_cur = i;                             // adc_n: nothing due, result ignored
+    if (i < adc_n && adc_tab[i].channel != adc_chs) {
+        adc_chs = adc_tab[i].channel;
+        ADCON0 = (unsigned char)((adc_chs << 2) | 0x01);
+    }
+}
+
+
+// Per entry results
+
+// 16-bit values written by the ISR: copy them with it held off
+unsigned int ADC_Latest(unsigned char entry) {
+    unsigned char ie = PIE1bits.ADIE;
+    PIE1bits.ADIE = 0;
+    unsigned int v = adc_latest[entry];
+    PIE1bits.ADIE = ie;
+    return v;
+}
+
+unsigned int ADC_Average(unsigned char entry) {
+    unsigned char ie = PIE1bits.ADIE;
+    PIE1bits.ADIE = 0;
+    unsigned int v = adc_avg[entry];
+    PIE1bits.ADIE = ie;
+    return (v + (1u << (ADC_AVG_SHIFT - 1))) >> ADC_AVG_SHIFT;
+}
+
+unsigned int ADC_Rate_Hz(unsigned char entry) {
+    if (entry >= adc_n) return 0;
+    return (adc_tick_hz / adc_every[entry]) >> (2 * adc_tab[entry].extra_bits);
+}
+
+
+// Ring side
+
+// ISR side: an adc_scan_t 'done' callback
+void ADC_Queue(unsigned int v) {
+
+    adc_count++;
+    unsigned char head = adc_head;
+    unsigned char next = (head + 1) & ADC_RING_MASK;
+    if (next == adc_tail) {          // full: keep the older samples
+        adc_dropped++;
+        return;
+    }
+    adc_ring[head] = v;
+    adc_head = next;                 // publish after the data is stored
+}
+
+unsigned char ADC_Available(void) {
+    return (adc_head - adc_tail) & ADC_RING_MASK;
+}
+
+unsigned char ADC_Read(unsigned int *sample) {
+    unsigned char tail = adc_tail;
+    if (tail == adc_head)
+        return 0;
+    *sample = adc_ring[tail];
+    adc_tail = (tail + 1) & ADC_RING_MASK;
+    return 1;
+}
+
+// 32-bit counter: copy it with the ADC interrupt held off
+unsigned long ADC_Sample_Count(void) {
+    unsigned char ie = PIE1bits.ADIE;
+    PIE1bits.ADIE = 0;
+    unsigned long n = adc_count;
+    PIE1bits.ADIE = ie;
+    return n;
+}
+
+// 16 bits are two byte reads on the PIC18: the same applies
+unsigned int ADC_Dropped(void) {
+    unsigned char ie = PIE1bits.ADIE;
+    PIE1bits.ADIE = 0;
+    unsigned int n = adc_dropped;
+    PIE1bits.ADIE = ie;
+    return n;
+}
@@ -0,0 +1,127 @@
+#include "debounce.h"
+
+
+// Debounce state
+
+// db_cnt1:db_cnt0 is one 2-bit counter per pin, bit n of each byte
+// for RBn. It counts ticks on which the pin disagreed with db_state
+// and is reset by any tick on which it agreed. db_lock1:db_lock0
+// counts down the ticks a pin ignores Debounce_Edge after one.
+static unsigned char db_pins;             // Buttons
+static unsigned char db_state;            // 1 = pressed
+static unsigned char db_cnt0, db_cnt1;
+static unsigned char db_lock0, db_lock1;
+static volatile unsigned char db_press;   // Events not yet taken
+static volatile unsigned char db_release;
+
+
+// Tick
+
+// Every counter steps in parallel: the pins that differ count up,
+// the others go back to 0; a counter wrapping past 3 flips that
+// pin's state and latches the edge.
+void Debounce_Tick(void) {
+    unsigned char diff = (db_state ^ (unsigned char)~PORTB) & db_pins;
+    db_cnt1 = (db_cnt1 ^ db_cnt0) & diff;
+    db_cnt0 = ~db_cnt0 & diff;
+    unsigned char flip = diff & ~(db_cnt0 | db_cnt1);
+
+    db_state ^= flip;
+    db_press |= flip & db_state;
+    db_release |= flip & ~db_state;
+
+    unsigned char t = db_lock1 & ~db_lock0;   // Lockout 3 -> 2 -> 1 -> 0
+    db_lock1 &= db_lock0;
+    db_lock0 = t;
+}
+
+void Debounce_ISR_Handler(void) {
+    PIR5bits.TMR6IF = 0;
+    Debounce_Tick();
+}
+
+
+// Edge reported by an interrupt
+
+// Takes the pins' new level as debounced straight away. Called from
+// the ISR, like the tick, so no locking is needed here.
+void Debounce_Edge(unsigned char pins) {
+    unsigned char flip = (db_state ^ (unsigned char)~PORTB) & pins & db_pins
+                         & ~(db_lock0 | db_lock1);
+    db_state ^= flip;
+    db_press |= flip & db_state;
+    db_release |= flip & ~db_state;
+    db_cnt0 &= ~flip;
+    db_cnt1 &= ~flip;
+    db_lock0 |= flip;
+    db_lock1 |= flip;
+}
+
+
+// Event masks
+
+// Read-and-clear with interrupts held off, so an edge latched by an
+// ISR in between is not lost.
+unsigned char Debounce_Pressed(unsigned char mask) {
+    unsigned char gie = INTCONbits.GIE;
+    INTCONbits.GIE = 0;
+    unsigned char e = db_press & mask;
+    db_press ^= e;
+    INTCONbits.GIE = gie;
+    return e;
+}
+
+unsigned char Debounce_Released(unsigned char mask) {
+    unsigned char gie = INTCONbits.GIE;
+    INTCONbits.GIE = 0;
+    unsigned char e = db_release & mask;
+    db_release ^= e;
+    INTCONbits.GIE = gie;
+    return e;
+}
+
+unsigned char Debounce_Held(void) {
+    return db_state;
+}
+
+unsigned char Debounce_Pending(void) {
+    return db_press;
+}
+
+// A counter or lockout running, or a pin away from its debounced level
+unsigned char Debounce_Busy(void) {
+    return db_cnt0 | db_cnt1 | db_lock0 | db_lock1
+         | ((db_state ^ (unsigned char)~PORTB) & db_pins);
+}
+
+
+// Initialisation
+
+// Buttons already down at power-up count as held, not as a press.
+// Timer6: Fosc/4 / 16 = 4 us counts, PR6 = 249 gives 1 ms, the
+// postscaler makes it DEBOUNCE_TICK_MS.
+void Debounce_Init_Polled(unsigned char pins) {
+    db_pins = pins;
+    db_state = (unsigned char)~PORTB & pins;
+    db_cnt0 = 0;
+    db_cnt1 = 0;
+    db_lock0 = 0;
+    db_lock1 = 0;
+    db_press = 0;
+    db_release = 0;
+}
+
+void Debounce_Init(unsigned char pins) {
+    Debounce_Init_Polled(pins);
+
+    T6CON = 0x00;
+    T6CONbits.T6CKPS = 2;                 // 1:16
+    T6CONbits.T6OUTPS = DEBOUNCE_TICK_MS - 1;
+    TMR6 = 0;
+    PR6 = 249;
+
+    PIR5bits.TMR6IF = 0;
+    PIE5bits.TMR6IE = 1;
+    INTCONbits.PEIE = 1;
+    T6CONbits.TMR6ON = 1;
+}
@@ -1,35 +1,266 @@
 #include "lcd.h"
 #include "config_bits.h"
 
+#if LCD_BUS_8BIT
+HAL_SIM_LCD(PORTD, 0, PORTE, 0, 1, -1, 1)  // host simulator wiring
+#else
+HAL_SIM_LCD(PORTB, 0, PORTB, 4, 5, 6, 0)
+#endif
 
-// Send a 4-bit nibble to the LCD (4-bit interface)
-// The LCD is operated in 4-bit mode 
-// Each char is sent as two nibbles (high then low).
 
-void LCD_Nibble(char nibble) {
-    // Output the nibble bits onto LCD data lines D4?D7
-    LCD_D4 = (nibble >> 0) & 1;
-    LCD_D5 = (nibble >> 1) & 1;
-    LCD_D6 = (nibble >> 2) & 1;
-    LCD_D7 = (nibble >> 3) & 1;
+// Shadow of the visible DDRAM (2 rows x 16 columns)
+
+// lcd_want holds what the application asked for and lcd_have what the
+// panel currently shows. LCD_Flush() sends only the cells that differ.
+// lcd_addr mirrors the controller's address counter so a cursor command
+// is only sent when the next changed cell is not the next address.
+static char lcd_want[2][16];
+static char lcd_have[2][16];
+static unsigned char lcd_addr;
+static unsigned char buf_row, buf_col;   // write position for LCD_Buf_*
+
+unsigned long lcd_bus_transactions;      // enable pulses sent to the LCD
+
+
+// Put one transfer on the data bus
+
+// On the 4-bit bus this is a nibble (bits 0..3 of b) and each byte
+// takes two transfers, high nibble first. On the 8-bit bus it is the
+// whole byte. Either way the data goes out in one port write.
+void LCD_Bus_Write(char b) {
+#if LCD_BUS_8BIT
+    LCD_DATA_LAT = b;
+#else
+    // D4..D7 sit on RB0..RB3
+    LCD_DATA_LAT = (LCD_DATA_LAT & ~LCD_DATA_MASK) | (b & LCD_DATA_MASK);
+#endif
 
     // Enable pulse latches data into LCD controller
     LCD_EN = 1;
-    __delay_us(50);
+    NOP();                        // PWEH >= 230 ns, one Tcy is 250 ns
     LCD_EN = 0;
-    __delay_us(50);
+    lcd_bus_transactions++;
+}
+
+
+#if !LCD_ASYNC
+
+// Wait until the LCD can accept the next byte (synchronous mode)
+
+// With R/W wired the busy flag (D7) is polled; each poll is two
+// read strobes because the status byte also comes as two nibbles.
+// Without R/W the worst-case execution time is waited out instead.
+static void LCD_Wait(unsigned int exec_us) {
+#if LCD_USE_BUSY_FLAG
+    unsigned char busy;
+    (void)exec_us;
+
+    LCD_DATA_TRIS |= LCD_DATA_MASK;   // D4..D7 become inputs
+    LCD_RS = 0;
+    LCD_RW = 1;                       // Read busy flag / address
+    do {
+        LCD_EN = 1;
+        NOP();                        // tDDR <= 160 ns
+        busy = LCD_BUSY;              // D7 of the high nibble
+        LCD_EN = 0;
+        LCD_EN = 1;                   // Low nibble (address), ignored
+        NOP();
+        LCD_EN = 0;
+    } while (busy);
+    LCD_RW = 0;
+    LCD_DATA_TRIS &= ~LCD_DATA_MASK;
+#else
+    if (exec_us > 100)
+        __delay_ms(2);                // Clear / return home
+    else
+        __delay_us(50);
+#endif
+}
+
+#endif
+
+
+#if LCD_ASYNC
+
+// Interrupt-drained command queue
+
+// LCD_Cmd / LCD_Char only enqueue and return. Each Timer4 interrupt
+// sends one entry (a whole byte, as two nibbles on the 4-bit bus) and
+// reloads Timer4 with that entry's execution time, so the next
+// interrupt comes when the LCD can take the next one: one interrupt
+// per byte and one per wait of up to 16 ms. Timer4 is stopped while
+// the queue is empty. The main loop is the only producer and the ISR
+// the only consumer, so the 8-bit head/tail need no locking.
+#define LCD_Q_CMD    0
+#define LCD_Q_DATA   1
+#define LCD_Q_RAW    2            // Raw bus transfer, init sequence only
+#define LCD_Q_WAIT   3            // Idle for 'byte' milliseconds
+#define LCD_Q_MASK   (LCD_QUEUE_SIZE - 1)
+
+// Timer4 reloads. Microseconds: 1:1 prescaler, 0.25 us counts.
+// Milliseconds: 1:16 prescaler and PR4 = 249 make 1 ms per match,
+// the postscaler counts 1..16 of them. Clear and return home take
+// 1.52 ms: 190 counts of 4 us, twice.
+#define LCD_T4_US         0x04    // On, 1:1, 1:1
+#define LCD_T4_MS(n)      ((unsigned char)((((n) - 1) << 3) | 0x06))
+#define LCD_PR4_US(us)    ((unsigned char)(_XTAL_FREQ / 4000000UL * (us) - 1))
+#define LCD_PR4_MS        249
+#define LCD_PR4_CLEAR     189     // With LCD_T4_MS(2)
+#define LCD_WAIT_MAX_MS   16
+
+static unsigned char lcd_q_kind[LCD_QUEUE_SIZE];
+static unsigned char lcd_q_byte[LCD_QUEUE_SIZE];
+static volatile unsigned char lcd_q_head;   // written by main loop
+static volatile unsigned char lcd_q_tail;   // written by ISR
+static unsigned char lcd_wait_ms;           // rest of a wait over 16 ms
+
+unsigned int lcd_q_overflows;               // entries dropped, queue full
+unsigned char lcd_q_high_water;             // most entries ever queued
+
+unsigned char LCD_Pending(void) {
+    return (lcd_q_head - lcd_q_tail) & LCD_Q_MASK;
+}
+
+static unsigned char LCD_Room(void) {
+    return LCD_Q_MASK - LCD_Pending();
+}
+
+// Next Timer4 interrupt after one full period of the new setting;
+// writing TMR4 also clears the prescaler and postscaler. A match of
+// the old, shorter period while a transfer was going out is dropped.
+static void LCD_Arm(unsigned char t4con, unsigned char pr) {
+    T4CON = t4con;
+    TMR4 = 0;
+    PR4 = pr;
+    PIR5bits.TMR4IF = 0;
+}
+
+static void LCD_Arm_Ms(unsigned char ms) {
+    unsigned char n = (ms > LCD_WAIT_MAX_MS) ? LCD_WAIT_MAX_MS : ms;
+    lcd_wait_ms = ms - n;
+    LCD_Arm(LCD_T4_MS(n), LCD_PR4_MS);
 }
 
+static unsigned char LCD_Enqueue(unsigned char kind, unsigned char b) {
+    unsigned char head = lcd_q_head;
+    if (LCD_Room() == 0) {
+        lcd_q_overflows++;
+        return 0;
+    }
+    lcd_q_kind[head] = kind;
+    lcd_q_byte[head] = b;
+    lcd_q_head = (head + 1) & LCD_Q_MASK;
+
+    unsigned char used = LCD_Pending();
+    if (used > lcd_q_high_water)
+        lcd_q_high_water = used;
+
+    if (!T4CONbits.TMR4ON)        // Idle: the last wait is over, go soon
+        LCD_Arm(LCD_T4_US, LCD_PR4_US(4));
+    return 1;
+}
+
+
+// Timer4 interrupt handler
+
+// Sends at most one entry per call.
+void LCD_ISR_Handler(void) {
+    PIR5bits.TMR4IF = 0;
+
+    if (lcd_wait_ms) {            // Long wait not over yet
+        LCD_Arm_Ms(lcd_wait_ms);
+        return;
+    }
+
+    unsigned char tail = lcd_q_tail;
+    if (tail == lcd_q_head) {
+        T4CONbits.TMR4ON = 0;     // Nothing left to send
+        return;
+    }
+
+    unsigned char kind = lcd_q_kind[tail];
+    unsigned char b = lcd_q_byte[tail];
+
+    if (kind == LCD_Q_WAIT) {
+        LCD_Arm_Ms(b);
+    } else if (kind == LCD_Q_RAW) {
+        LCD_RS = 0;
+        LCD_Bus_Write(b);
+        LCD_Arm(LCD_T4_US, LCD_PR4_US(37));
+    } else {
+        LCD_RS = kind;            // LCD_Q_CMD = 0, LCD_Q_DATA = 1
+#if !LCD_BUS_8BIT
+        LCD_Bus_Write(b >> 4);    // High nibble first
+#endif
+        LCD_Bus_Write(b);
+        // Clear and return home take 1.52 ms, a write 37 us + 4 us
+        if (kind == LCD_Q_DATA)
+            LCD_Arm(LCD_T4_US, LCD_PR4_US(41));
+        else if (b == 0x01 || b == 0x02)
+            LCD_Arm(LCD_T4_MS(2), LCD_PR4_CLEAR);
+        else
+            LCD_Arm(LCD_T4_US, LCD_PR4_US(37));
+    }
+    lcd_q_tail = (tail + 1) & LCD_Q_MASK;
+}
+
+
+// Wait until everything queued has reached the LCD
+
+// Also works with interrupts disabled by running the handler here.
+void LCD_Wait_Idle(void) {
+    while (T4CONbits.TMR4ON) {
+        if (!INTCONbits.GIE && PIR5bits.TMR4IF)
+            LCD_ISR_Handler();
+    }
+}
+
+static unsigned char LCD_Send(unsigned char rs, char b) {
+    return LCD_Enqueue(rs ? LCD_Q_DATA : LCD_Q_CMD, b);
+}
+
+#else
+
+static unsigned char LCD_Room(void) {
+    return 0xFF;
+}
+
+void LCD_Wait_Idle(void) {
+}
+
+// Send one byte and wait until the LCD has executed it
+static unsigned char LCD_Send(unsigned char rs, char b) {
+    LCD_RS = rs;                  // 0 = command, 1 = data register
+#if LCD_BUS_8BIT
+    LCD_Bus_Write(b);
+#else
+    LCD_Bus_Write(b >> 4);        // Send high nibble
+    LCD_Bus_Write(b);             // Send low nibble
+#endif
+
+    // Clear and return home take 1.52 ms, a write 37 us + 4 us
+    if (rs)
+        LCD_Wait(41);
+    else
+        LCD_Wait((b == 0x01 || b == 0x02) ? 1520 : 37);
+    return 1;
+}
+
+#endif
+
 
 // Send a command byte to the LCD (RS = 0)
 
 // Commands control LCD behaviour such as clearing the
 // display or moving the cursor.
 void LCD_Cmd(char cmd) {
-    LCD_RS = 0;                   // Select command register
-    LCD_Nibble(cmd >> 4);         // Send high nibble
-    LCD_Nibble(cmd);              // Send low nibble
-    __delay_ms(2);                // Command execution delay
+    if (!LCD_Send(0, cmd))
+        return;
+
+    if (cmd & 0x80)
+        lcd_addr = cmd & 0x7F;    // Set DDRAM address
+    else if (cmd == 0x01 || cmd == 0x02)
+        lcd_addr = 0;             // Clear / return home
 }
 
 
@@ -38,32 +269,82 @@ void LCD_Cmd(char cmd) {
 // Character data is written into the LCD DDRAM and
 // appears at the current cursor position.
 void LCD_Char(char dat) {
-    LCD_RS = 1;                   // Select data register
-    LCD_Nibble(dat >> 4);         // High nibble
-    LCD_Nibble(dat);              // Low nibble
-    __delay_us(50);               // Short data hold delay
+    if (!LCD_Send(1, dat))
+        return;
+
+    // Keep the shadow in step with what is now on the panel
+    unsigned char row = lcd_addr >> 6;
+    unsigned char col = lcd_addr & 0x3F;
+    if (col < 16) {
+        lcd_have[row][col] = dat;
+        lcd_want[row][col] = dat;
+    }
+    lcd_addr++;
+    if (lcd_addr == 0x28) lcd_addr = 0x40;      // End of row 1 wraps to row 2
+    else if (lcd_addr == 0x68) lcd_addr = 0x00;
 }
 
 
 // Initialise the LCD module
 
 // Follows the HD44780 initialisation sequence to force
-// the LCD into a known 4-bit operating mode.
+// the LCD into a known 4-bit or 8-bit operating mode.
+// With LCD_ASYNC the whole sequence is queued and this returns at once;
+// interrupts must be enabled for it to run.
+
+// Function set "8-bit" as it appears on the bus during reset
+#if LCD_BUS_8BIT
+#define LCD_RESET 0x30
+#else
+#define LCD_RESET 0x03
+#endif
+
 void LCD_Init(void) {
+#if LCD_BUS_8BIT
+    ANSELD = 0x00;                // PORTD data bus, digital outputs
+    TRISD = 0x00;
+    ANSELE = 0x00;                // RS = RE0, EN = RE1
+    TRISEbits.TRISE0 = 0;
+    TRISEbits.TRISE1 = 0;
+#else
     TRISB = 0x00;                 // PORTB used for LCD I/O
+    LCD_RW = 0;
+#endif
     LCD_RS = 0;
     LCD_EN = 0;
 
+#if LCD_ASYNC
+    // Timer4: Fosc/4, reloaded for every entry (LCD_Arm)
+    T4CON = 0x00;
+    lcd_wait_ms = 0;
+    PIR5bits.TMR4IF = 0;
+    PIE5bits.TMR4IE = 1;
+    INTCONbits.PEIE = 1;
+
+    LCD_Enqueue(LCD_Q_WAIT, 20);           // LCD power-up delay
+    LCD_Enqueue(LCD_Q_RAW, LCD_RESET);     // Reset sequence
+    LCD_Enqueue(LCD_Q_WAIT, 5);
+    LCD_Enqueue(LCD_Q_RAW, LCD_RESET);
+    LCD_Enqueue(LCD_Q_WAIT, 1);
+    LCD_Enqueue(LCD_Q_RAW, LCD_RESET);
+#if !LCD_BUS_8BIT
+    LCD_Enqueue(LCD_Q_RAW, 0x02);          // Switch to 4-bit mode
+#endif
+#else
     __delay_ms(20);               // LCD power-up delay
     
     // Reset sequence required by LCD datasheet
-    LCD_Nibble(0x03); __delay_ms(5);
-    LCD_Nibble(0x03); __delay_us(150);
-    LCD_Nibble(0x03);
-    LCD_Nibble(0x02);             // Switch to 4-bit mode
+    // The busy flag cannot be read yet, so these steps use fixed delays
+    LCD_Bus_Write(LCD_RESET); __delay_ms(5);
+    LCD_Bus_Write(LCD_RESET); __delay_us(150);
+    LCD_Bus_Write(LCD_RESET); __delay_us(50);
+#if !LCD_BUS_8BIT
+    LCD_Bus_Write(0x02); __delay_us(50);   // Switch to 4-bit mode
+#endif
+#endif
     
     // LCD configuration commands
-    LCD_Cmd(0x28);                // 2-line display, 5×8 font
+    LCD_Cmd(LCD_FUNCTION_SET);    // Bus width, 2-line display, 5×8 font
     LCD_Cmd(0x0C);                // Display ON, cursor OFF
     LCD_Cmd(0x06);                // Entry mode: auto increment
     LCD_Clear();                  // Clear display and reset cursor
@@ -99,6 +380,51 @@ void LCD_Set_Cursor(unsigned char row, unsigned char col) {
 
 // Clears all characters and resets cursor to (0,0).
 void LCD_Clear(void) {
-    LCD_Cmd(0x01);                // Clear display command
-    __delay_ms(2);                // Clear operation delay
+    LCD_Cmd(0x01);                // Clear display (waits 1.52 ms)
+
+    for (unsigned char i = 0; i < 16; i++) {
+        lcd_want[0][i] = lcd_have[0][i] = ' ';
+        lcd_want[1][i] = lcd_have[1][i] = ' ';
+    }
+}
+
+
+// Buffered output
+
+// LCD_Buf_Set_Cursor / LCD_Buf_Char / LCD_Buf_String only change the
+// RAM shadow. Nothing reaches the panel until LCD_Flush().
+void LCD_Buf_Set_Cursor(unsigned char row, unsigned char col) {
+    buf_row = (row == 1) ? 0 : 1;
+    buf_col = col;
+}
+
+void LCD_Buf_Char(char dat) {
+    if (buf_col < 16)
+        lcd_want[buf_row][buf_col++] = dat;
+}
+
+void LCD_Buf_String(const char* str) {
+    while (*str && buf_col < 16)
+        lcd_want[buf_row][buf_col++] = *str++;
+}
+
+
+// Write the changed cells to the LCD
+
+// Consecutive changed cells go out back to back; the cursor command is
+// only sent when there is a gap. With LCD_ASYNC it stops when the queue
+// is full and the remaining cells go out on the next call.
+void LCD_Flush(void) {
+    for (unsigned char row = 0; row < 2; row++) {
+        for (unsigned char col = 0; col < 16; col++) {
+            if (lcd_want[row][col] == lcd_have[row][col])
+                continue;
+            if (LCD_Room() < 2)
+                return;
+            unsigned char address = (row ? 0x40 : 0x00) + col;
+            if (address != lcd_addr)
+                LCD_Cmd(0x80 | address);
+            LCD_Char(lcd_want[row][col]);
+        }
+    }
 }
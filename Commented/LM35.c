@@ -1,4 +1,6 @@
 #include "lm35.h"
+#include "adc.h"
+#include "calib.h"
 #include "config_bits.h"
 
 
@@ -7,45 +9,55 @@
 // The LM35 is connected to AN6, which corresponds to
 // analogue channel on pin RE1. Only this pin is set
 // as analogue input; other PORTE pins remain digital.
+// Conversions then run continuously at LM35_RATE_HZ
+// readings per second, each oversampled as set by
+// LM35_EXTRA_BITS (see adc.h); the ADC interrupt must
+// be dispatched to ADC_ISR_Handler().
 void LM35_Init(void) {
 
     // Configure PORTE pins
     ANSELEbits.ANSE2 = 0; // RE2 as digital I/O
     ANSELEbits.ANSE1 = 1; // RE1 as analogue input (AN6 - LM35)
     ANSELEbits.ANSE0 = 0; // RE0 as digital I/O
+    TRISEbits.TRISE1 = 1;
 
-    // Select ADC input channel
-    ADCON0bits.CHS = 7;   // Channel select: AN6
+    // Channel AN6, right-justified, hardware-timed sampling
+    ADC_Start(LM35_CHANNEL, LM35_RATE_HZ, LM35_EXTRA_BITS);
+}
+
+
+// Newest reading, 10 + LM35_EXTRA_BITS bits
 
-    // Configure ADC voltage references
-    ADCON1bits.PVCFG = 0; // Positive reference = VDD
-    ADCON1bits.NVCFG = 0; // Negative reference = VSS
+// Never waits: takes whatever samples the ADC interrupt
+// has queued and keeps the newest one. Until the first
+// reading completes the previous value (0) is returned.
+static unsigned int LM35_Latest(void) {
 
-    // Configure ADC timing
-    ADCON2bits.ACQT = 4;  // Acquisition time
-    ADCON2bits.ADCS = 2;  // ADC conversion clock
+    static unsigned int adc_val;
+    unsigned int s;
 
-    // Enable ADC module
-    ADCON0bits.ADON = 1;
+    while (ADC_Read(&s))      // Keep the newest sample
+        adc_val = s;
+    return adc_val;
 }
 
 
 // Read temperature value from LM35 in °C
 
-// Starts an ADC conversion, waits for completion,
-// then converts the 10-bit result into degrees Celsius
-// using integer arithmetic (no floating-point).
+// Whole degrees of the calibrated T100 reading; the
+// division by 100 is a multiply and shift, exact for
+// any T100 the table can hold (see bcd.c).
 unsigned int LM35_Read_Temp(void) {
 
-    ADCON0bits.GO = 1;        // Start ADC conversion
-    __delay_ms(1);            // Short sample delay
-    while (ADCON0bits.GO);    // Wait until conversion completes
+    return (unsigned int)(((unsigned long)LM35_Read_T100() * 5243u) >> 19);
+}
+
 
-    // Combine high and low ADC result registers
-    unsigned int adc_val = (ADRESH << 8) + ADRESL;
+// Read temperature in hundredths of a degree (T100)
 
-    // Scaling converts ADC value directly to °C
-    unsigned long temp = (unsigned long)adc_val * 500;
+// Calibration table lookup (calib.h), with the
+// oversampled bits interpolating between entries.
+unsigned int LM35_Read_T100(void) {
 
-    return (unsigned int)(temp / 1024);
+    return cal_T100(LM35_Latest(), LM35_EXTRA_BITS);
 }
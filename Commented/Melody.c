@@ -0,0 +1,125 @@
+#include "melody.h"
+
+
+// State
+
+static const unsigned char *mel_song;     // Song start, for looping
+static const unsigned char *mel_pos;      // Next note pair, 0 = no song
+static unsigned int mel_step;             // ms per step
+static unsigned char mel_gap;             // ms of silence after each note
+static unsigned char mel_gap_due;         // That silence comes next
+static unsigned char mel_loop;
+static volatile unsigned char mel_active; // Song or queued note running
+
+static unsigned char mel_q_note[MELODY_QUEUE];
+static unsigned int mel_q_ms[MELODY_QUEUE];
+static unsigned char mel_q_head, mel_q_count;
+
+
+// Start whatever comes next
+
+// Called from the tick interrupt when a note has ended, or with the
+// tick interrupt masked. Queued notes go between the end of the song
+// and the next pass.
+static void melody_next(void) {
+    unsigned char note;
+    unsigned int ms;
+
+    if (mel_gap_due) {
+        mel_gap_due = 0;
+        Tone_Play(TONE_REST, mel_gap);
+        return;
+    }
+
+    if (mel_pos && *mel_pos == MELODY_END && mel_q_count == 0) {
+        if (mel_loop)
+            mel_pos = mel_song + 3;
+        else
+            mel_pos = 0;
+    }
+
+    if (mel_pos && *mel_pos != MELODY_END) {
+        note = mel_pos[0];
+        ms = mel_step * mel_pos[1];
+        mel_pos += 2;
+        if (mel_gap) {
+            ms -= mel_gap;
+            mel_gap_due = 1;
+        }
+        Tone_Play(note, ms);
+        return;
+    }
+
+    if (mel_q_count) {
+        Tone_Play(mel_q_note[mel_q_head], mel_q_ms[mel_q_head]);
+        mel_q_head = (mel_q_head + 1) & (MELODY_QUEUE - 1);
+        mel_q_count--;
+        return;
+    }
+
+    mel_active = 0;
+}
+
+
+// Timer2, 1 ms: the note's countdown, then the next note
+
+void Melody_Tick_Handler(void) {
+    Tone_Tick_Handler();
+    if (mel_active && !Tone_Busy())
+        melody_next();
+}
+
+
+// Control
+
+// The tick interrupt is masked while the state changes under it, then
+// left as it was found.
+void Melody_Start(const unsigned char *song, unsigned char loop) {
+    unsigned char ie = PIE1bits.TMR2IE;
+    PIE1bits.TMR2IE = 0;
+    mel_song = song;
+    mel_pos = song + 3;
+    mel_step = song[0] | ((unsigned int)song[1] << 8);
+    mel_gap = song[2];
+    mel_gap_due = 0;
+    mel_loop = loop;
+    mel_active = 1;
+    melody_next();
+    PIE1bits.TMR2IE = ie;
+}
+
+void Melody_Stop(void) {
+    unsigned char ie = PIE1bits.TMR2IE;
+    PIE1bits.TMR2IE = 0;
+    mel_pos = 0;
+    mel_gap_due = 0;
+    mel_q_count = 0;
+    mel_active = 0;
+    Tone_Stop();
+    PIE1bits.TMR2IE = ie;
+}
+
+unsigned char Melody_Playing(void) {
+    return mel_active;
+}
+
+unsigned char Melody_Queue(unsigned char note, unsigned int ms) {
+    unsigned char ok = 0, start;
+    unsigned char ie = PIE1bits.TMR2IE;
+
+    if (ms == 0)                     // Tone_Play would hold it for ever
+        ms = 1;
+    PIE1bits.TMR2IE = 0;
+    if (mel_q_count < MELODY_QUEUE) {
+        mel_q_note[(mel_q_head + mel_q_count) & (MELODY_QUEUE - 1)] = note;
+        mel_q_ms[(mel_q_head + mel_q_count) & (MELODY_QUEUE - 1)] = ms;
+        mel_q_count++;
+        ok = 1;
+        start = !mel_active && !Tone_Busy();
+        mel_active = 1;
+        if (start)
+            melody_next();
+    }
+    PIE1bits.TMR2IE = ie;
+    return ok;
+}
@@ -0,0 +1,137 @@
+#include "power.h"
+#include "debounce.h"
+
+
+// State
+
+static unsigned char pwr_pins;            // Wake-up pins
+static volatile unsigned int pwr_t5_ovf;  // Timer5 overflows (2 us counts)
+static unsigned long pwr_wakes;
+static unsigned long pwr_awake_since;     // Timer5 count at the last wake-up
+static unsigned long pwr_active;          // Timer5 counts spent awake
+
+
+// Timer5 as a 32-bit count of 2 us; it stops in Sleep
+
+static unsigned long Power_Now(void) {
+    unsigned int ovf;
+    unsigned char l, h;
+    do {
+        ovf = pwr_t5_ovf;
+        l = TMR5L;                        // latches TMR5H
+        h = TMR5H;
+    } while (ovf != pwr_t5_ovf);
+    return ((unsigned long)ovf << 16) | ((unsigned int)h << 8) | l;
+}
+
+
+// Edge polarity
+
+// INT0..INT2 fire on one edge only: the next one expected is a
+// release for a pin that is held and a press otherwise.
+static void Power_Set_Edges(void) {
+    unsigned char held = Debounce_Held();
+    INTCON2bits.INTEDG0 = held & 0x01 ? 1 : 0;
+    INTCON2bits.INTEDG1 = held & 0x02 ? 1 : 0;
+    INTCON2bits.INTEDG2 = held & 0x04 ? 1 : 0;
+}
+
+
+// Interrupt
+
+void Power_ISR_Handler(void) {
+    unsigned char ic = INTCON;            // flag bits sit 3 below their enables
+    unsigned char ic3 = INTCON3;
+    unsigned char edge = 0;
+
+    if (ic & (ic >> 3) & 0x02) {          // INT0
+        INTCONbits.INT0IF = 0;
+        edge |= 0x01;
+    }
+    ic3 &= (ic3 >> 3) & 0x03;             // INT1, INT2: clear only those
+    if (ic3 & 0x01)                       // taken, not one that came since
+        INTCON3bits.INT1IF = 0;
+    if (ic3 & 0x02)
+        INTCON3bits.INT2IF = 0;
+    edge |= ic3 << 1;
+    if (ic & (ic >> 3) & 0x01) {          // RB4..RB7 change
+        (void)PORTB;                      // ends the mismatch
+        INTCONbits.RBIF = 0;
+        edge |= pwr_pins & 0xF0;
+    }
+    if (PIR5bits.TMR5IF) {
+        PIR5bits.TMR5IF = 0;
+        pwr_t5_ovf++;
+    }
+
+    if (edge) {
+        Debounce_Edge(edge);
+        Power_Set_Edges();
+    }
+}
+
+
+// Sleep until the next interrupt
+
+// Full Sleep stops every timer clocked from Fosc, so it is only used
+// when neither the debouncer nor the caller needs one; otherwise
+// Idle. The choice and SLEEP are made with interrupts held off: an
+// edge in between leaves its flag set, which still wakes the core
+// (at once), and a press latched since the caller last looked skips
+// the sleep. The interrupt (if GIE) runs before this returns.
+void Power_Sleep(unsigned char busy) {
+    unsigned char gie = INTCONbits.GIE;
+
+    pwr_active += Power_Now() - pwr_awake_since;
+    INTCONbits.GIE = 0;
+    if (!Debounce_Pending()) {
+        Power_Set_Edges();
+        OSCCONbits.IDLEN = (busy || Debounce_Busy()) ? 1 : 0;
+        SLEEP();
+        NOP();
+        pwr_wakes++;
+    }
+    INTCONbits.GIE = gie;                 // The wake-up interrupt runs here
+    pwr_awake_since = Power_Now();
+}
+
+
+// Initialisation
+
+// Buttons are active low, so the first edge looked for is a falling
+// one; RB4..RB7 interrupt on either edge. Timer5 counts Fosc/4 / 8.
+void Power_Init(unsigned char pins) {
+    pwr_pins = pins;
+    pwr_wakes = 0;
+    pwr_active = 0;
+    pwr_t5_ovf = 0;
+
+    T5CON = 0x33;                         // Fosc/4, 1:8, 16-bit reads, on
+    PIR5bits.TMR5IF = 0;
+    PIE5bits.TMR5IE = 1;
+    INTCONbits.PEIE = 1;
+    pwr_awake_since = Power_Now();
+
+    Power_Set_Edges();
+    IOCB = pins & 0xF0;
+    (void)PORTB;
+    INTCONbits.INT0IF = 0;
+    INTCON3bits.INT1IF = 0;
+    INTCON3bits.INT2IF = 0;
+    INTCONbits.RBIF = 0;
+    INTCONbits.INT0IE = pins & 0x01 ? 1 : 0;
+    INTCON3bits.INT1IE = pins & 0x02 ? 1 : 0;
+    INTCON3bits.INT2IE = pins & 0x04 ? 1 : 0;
+    INTCONbits.RBIE = pins & 0xF0 ? 1 : 0;
+}
+
+
+// Counters
+
+unsigned long Power_Wakes(void) {
+    return pwr_wakes;
+}
+
+unsigned long Power_Active_Us(void) {
+    return (pwr_active + Power_Now() - pwr_awake_since) * 2;
+}
@@ -0,0 +1,253 @@
+#include "sched.h"
+
+
+// Tasks
+
+static sched_task_t task_fn[SCHED_TASKS];
+static unsigned char task_count;
+static volatile unsigned char sched_ready;   // Bit n: task n posted
+static unsigned int task_runs[SCHED_TASKS];
+static unsigned int task_wcet[SCHED_TASKS];
+static volatile unsigned int task_overruns[SCHED_TASKS];
+
+static const unsigned char SCHED_BIT[8] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80 };
+
+
+// Timers
+
+// Each wheel slot heads a list of the timers due on a tick with the
+// same low bits, linked through tm_next. A free timer has no task.
+static unsigned char tm_task[SCHED_TIMERS];
+static unsigned int tm_due[SCHED_TIMERS];
+static unsigned int tm_period[SCHED_TIMERS];  // 0 = one-shot
+static unsigned char tm_next[SCHED_TIMERS];
+static unsigned char wheel[SCHED_WHEEL];
+
+static volatile unsigned int sched_ticks;
+static unsigned char sched_on;
+
+
+// Called from the tick, or with it masked
+static void sched_post(unsigned char task) {
+    unsigned char bit = SCHED_BIT[task];
+    if (sched_ready & bit)
+        task_overruns[task]++;
+    sched_ready |= bit;
+}
+
+static void wheel_insert(unsigned char t) {
+    unsigned char *slot = &wheel[(unsigned char)tm_due[t] & (SCHED_WHEEL - 1)];
+    tm_next[t] = *slot;
+    *slot = t;
+}
+
+static void wheel_remove(unsigned char t) {
+    unsigned char *link = &wheel[(unsigned char)tm_due[t] & (SCHED_WHEEL - 1)];
+    while (*link != SCHED_NONE) {
+        if (*link == t) {
+            *link = tm_next[t];
+            return;
+        }
+        link = &tm_next[*link];
+    }
+}
+
+
+// Timer6, 1 ms: expire the timers in this tick's slot
+
+// A periodic timer goes back in at its next due tick; that is never
+// the tick being walked, so it is not met again in this pass.
+void Sched_ISR_Handler(void) {
+    unsigned char *link, t;
+    unsigned int now;
+
+    PIR5bits.TMR6IF = 0;
+    now = ++sched_ticks;
+
+    link = &wheel[(unsigned char)now & (SCHED_WHEEL - 1)];
+    while ((t = *link) != SCHED_NONE) {
+        if (tm_due[t] != now) {
+            link = &tm_next[t];
+            continue;
+        }
+        *link = tm_next[t];
+        sched_post(tm_task[t]);
+        if (tm_period[t]) {
+            tm_due[t] = now + tm_period[t];
+            wheel_insert(t);
+        } else {
+            tm_task[t] = SCHED_NONE;
+        }
+    }
+}
+
+
+// Tasks and timers
+
+// Anything the tick also touches is changed with TMR6IE masked, then
+// TMR6IE is put back as it was: these may be called before Sched_Init
+// has started the tick, or with it masked, and must not turn it on.
+unsigned char Sched_Task(sched_task_t fn) {
+    if (task_count == SCHED_TASKS)
+        return SCHED_NONE;
+    task_fn[task_count] = fn;
+    return task_count++;
+}
+
+void Sched_Post(unsigned char task) {
+    unsigned char ie = PIE5bits.TMR6IE;
+    PIE5bits.TMR6IE = 0;
+    sched_post(task);
+    PIE5bits.TMR6IE = ie;
+}
+
+static unsigned char sched_timer(unsigned char task, unsigned int ms, unsigned int period) {
+    unsigned char t, ie;
+
+    if (task >= task_count || ms == 0)
+        return SCHED_NONE;
+    for (t = 0; t < SCHED_TIMERS; t++)
+        if (tm_task[t] == SCHED_NONE)
+            break;
+    if (t == SCHED_TIMERS)
+        return SCHED_NONE;
+
+    ie = PIE5bits.TMR6IE;
+    PIE5bits.TMR6IE = 0;
+    tm_task[t] = task;
+    tm_period[t] = period;
+    tm_due[t] = sched_ticks + ms;
+    wheel_insert(t);
+    PIE5bits.TMR6IE = ie;
+    return t;
+}
+
+unsigned char Sched_After(unsigned char task, unsigned int ms) {
+    return sched_timer(task, ms, 0);
+}
+
+unsigned char Sched_Every(unsigned char task, unsigned int ms) {
+    return sched_timer(task, ms, ms);
+}
+
+void Sched_Cancel(unsigned char timer) {
+    unsigned char ie;
+
+    if (timer >= SCHED_TIMERS)
+        return;
+    ie = PIE5bits.TMR6IE;
+    PIE5bits.TMR6IE = 0;
+    if (tm_task[timer] != SCHED_NONE) {
+        wheel_remove(timer);
+        tm_task[timer] = SCHED_NONE;
+    }
+    PIE5bits.TMR6IE = ie;
+}
+
+
+// Time
+
+unsigned int Sched_Millis(void) {
+    unsigned int t;
+    unsigned char ie = PIE5bits.TMR6IE;
+    PIE5bits.TMR6IE = 0;
+    t = sched_ticks;
+    PIE5bits.TMR6IE = ie;
+    return t;
+}
+
+unsigned char Sched_Active(void) {
+    return sched_on;
+}
+
+// Tick and Timer6 count (4 us) read as a pair; read again if the tick
+// moved in between
+static void sched_stamp(unsigned int *tick, unsigned char *count) {
+    do {
+        *tick = sched_ticks;
+        *count = TMR6;
+    } while (*tick != sched_ticks);
+}
+
+
+// Running
+
+unsigned char Sched_Run_Once(void) {
+    unsigned char task, bit, ie, c0, c1;
+    unsigned int t0, t1;
+    long us;
+
+    if (!sched_ready)
+        return 0;
+    for (task = 0; !(sched_ready & SCHED_BIT[task]); task++)
+        ;
+    bit = SCHED_BIT[task];
+    ie = PIE5bits.TMR6IE;
+    PIE5bits.TMR6IE = 0;
+    sched_ready &= ~bit;
+    PIE5bits.TMR6IE = ie;
+
+    sched_stamp(&t0, &c0);
+    task_fn[task]();
+    sched_stamp(&t1, &c1);
+
+    us = (long)(t1 - t0) * 1000 + ((int)c1 - (int)c0) * 4;
+    if (us > 65535)
+        us = 65535;
+    if ((unsigned int)us > task_wcet[task])
+        task_wcet[task] = (unsigned int)us;
+    task_runs[task]++;
+    return 1;
+}
+
+void Sched_Run(void) {
+    while (1) {
+        if (!Sched_Run_Once())
+            HAL_IDLE();
+    }
+}
+
+void Sched_Get_Stats(unsigned char task, sched_stats_t *s) {
+    unsigned char ie;
+
+    if (task >= task_count)
+        return;
+    s->runs = task_runs[task];
+    s->wcet_us = task_wcet[task];
+    ie = PIE5bits.TMR6IE;
+    PIE5bits.TMR6IE = 0;
+    s->overruns = task_overruns[task];
+    PIE5bits.TMR6IE = ie;
+}
+
+
+// Initialisation
+
+// Timer6: Fosc/4 / 16 = 4 us counts, PR6 = 249 gives 1 ms.
+void Sched_Init(void) {
+    unsigned char i;
+
+    PIE5bits.TMR6IE = 0;
+    for (i = 0; i < SCHED_TIMERS; i++)
+        tm_task[i] = SCHED_NONE;
+    for (i = 0; i < SCHED_WHEEL; i++)
+        wheel[i] = SCHED_NONE;
+    for (i = 0; i < SCHED_TASKS; i++) {
+        task_runs[i] = 0;
+        task_wcet[i] = 0;
+        task_overruns[i] = 0;
+    }
+    task_count = 0;
+    sched_ready = 0;
+    sched_ticks = 0;
+
+    T6CON = 0x00;
+    T6CONbits.T6CKPS = 2;                 // 1:16, postscaler 1:1
+    TMR6 = 0;
+    PR6 = 249;
+    PIR5bits.TMR6IF = 0;
+    PIE5bits.TMR6IE = 1;
+    INTCONbits.PEIE = 1;
+    T6CONbits.TMR6ON = 1;
+    sched_on = 1;
+}
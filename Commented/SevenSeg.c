@@ -1,4 +1,5 @@
 #include "sevenseg.h"
+#include "bcd.h"
 
 
 // Segment patterns for digits 0?9 (Common Cathode)
@@ -19,13 +20,73 @@ const unsigned char SEG_MAP[] = {
 };
 
 
-// Display buffer and refresh state
+// Glyphs for text, ASCII 0x20..0x7F (same bit order as SEG_MAP)
 
-// digits[] holds the segment patterns for each digit.
+// Covers hex and every letter a seven-segment digit can show in
+// upper or lower case. K, M, V, W and X have no usable shape and are
+// blank. '*' is drawn as a degree sign. A '.' is merged into the
+// previous character's decimal point where possible.
+static const unsigned char SEG_GLYPH[96] = {
+    //  sp     !     "     #     $     %     &     '
+    0x00, 0x86, 0x22, 0x00, 0x6D, 0x00, 0x00, 0x02,
+    //   (     )     *     +     ,     -     .     /
+    0x39, 0x0F, 0x63, 0x00, 0x80, 0x40, 0x80, 0x52,
+    //   0     1     2     3     4     5     6     7
+    0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07,
+    //   8     9     :     ;     <     =     >     ?
+    0x7F, 0x6F, 0x00, 0x00, 0x00, 0x48, 0x00, 0x53,
+    //   @     A     B     C     D     E     F     G
+    0x00, 0x77, 0x7C, 0x39, 0x5E, 0x79, 0x71, 0x3D,
+    //   H     I     J     K     L     M     N     O
+    0x76, 0x30, 0x1E, 0x00, 0x38, 0x00, 0x37, 0x3F,
+    //   P     Q     R     S     T     U     V     W
+    0x73, 0x67, 0x50, 0x6D, 0x78, 0x3E, 0x00, 0x00,
+    //   X     Y     Z     [     \     ]     ^     _
+    0x00, 0x6E, 0x5B, 0x39, 0x64, 0x0F, 0x23, 0x08,
+    //   `     a     b     c     d     e     f     g
+    0x20, 0x77, 0x7C, 0x58, 0x5E, 0x79, 0x71, 0x3D,
+    //   h     i     j     k     l     m     n     o
+    0x74, 0x10, 0x1E, 0x00, 0x30, 0x00, 0x54, 0x5C,
+    //   p     q     r     s     t     u     v     w
+    0x73, 0x67, 0x50, 0x6D, 0x78, 0x1C, 0x00, 0x00,
+    //   x     y     z     {     |     }     ~   del
+    0x00, 0x6E, 0x5B, 0x39, 0x30, 0x0F, 0x40, 0x00
+};
+
+
+// Display buffers and refresh state
+
+// Two frames of segment patterns. The ISR shows seg_frame[seg_front];
+// SevenSeg_Update_Value fills the other one and raises seg_swap. The
+// ISR flips seg_front only when it is about to draw digit 0, so one
+// scan never mixes digits of two values. Both flags are single bytes,
+// so neither side has to disable interrupts.
 // current_digit tracks which digit is being refreshed.
-volatile unsigned char digits[4] = {0, 0, 0, 0};
+volatile unsigned char seg_frame[2][4];
+volatile unsigned char seg_front = 0;  // frame the ISR is showing
+volatile unsigned char seg_swap = 0;   // back frame ready to show
 volatile unsigned char current_digit = 0;
 
+static unsigned int seg_value = 0xFFFF; // last value written (none yet)
+
+// Scroll mode. The text is encoded once into seg_scroll: the text,
+// a blank gap, then its first three patterns again so a window of four
+// never has to wrap. The ISR moves the window every seg_scroll_frames
+// scans and reads each digit with one indexed load.
+// Like the frame swap, mode changes requested by the main loop
+// (seg_mode_req) are taken by the ISR at digit 0.
+#define SEG_MODE_FRAME  0
+#define SEG_MODE_SCROLL 1
+#define SEG_SCROLL_GAP  4
+
+static unsigned char seg_scroll[SEG_SCROLL_MAX + SEG_SCROLL_GAP + 3];
+static unsigned char seg_scroll_len;     // text + gap
+static unsigned char seg_scroll_pos;     // leftmost pattern shown
+static unsigned char seg_scroll_frames;  // scans per step
+static unsigned char seg_scroll_count;
+static volatile unsigned char seg_mode = SEG_MODE_FRAME;      // ISR side
+static volatile unsigned char seg_mode_req = SEG_MODE_FRAME;  // main side
+
 
 // Initialise seven-segment display and Timer0
 
@@ -53,19 +114,110 @@ void SevenSeg_Init(void) {
 }
 
 
+// Hand four segment patterns (leftmost first) to the ISR
+
+// Writes the back frame and raises seg_swap; also ends scroll mode.
+static void SevenSeg_Load(const unsigned char p[4]) {
+
+    // Withdraw any frame still waiting; after this the ISR will not
+    // swap, so the back frame is ours until seg_swap is set again.
+    seg_swap = 0;
+    volatile unsigned char *back = seg_frame[seg_front ^ 1];
+
+    back[0] = p[0];
+    back[1] = p[1];
+    back[2] = p[2];
+    back[3] = p[3];
+
+    seg_swap = 1;                    // Shown from the next digit 0
+    seg_mode_req = SEG_MODE_FRAME;
+}
+
+
 // Update the number to be displayed
 
 // Splits an integer value into its individual digits
 // and loads the corresponding segment patterns into
-// the display buffer.
+// the back buffer, then hands it to the ISR.
+// Returns at once if the value is already displayed.
 void SevenSeg_Update_Value(unsigned int number) {
 
     if(number > 9999) number = 9999; // Clamp to display range
-    
-    digits[0] = SEG_MAP[number / 1000];       // Thousands
-    digits[1] = SEG_MAP[(number / 100) % 10]; // Hundreds
-    digits[2] = SEG_MAP[(number / 10) % 10];  // Tens
-    digits[3] = SEG_MAP[number % 10];         // Units
+    if(number == seg_value) return;
+    seg_value = number;
+
+    unsigned char d[4];
+    bin_to_bcd4(number, d);                 // Thousands first
+
+    d[0] = SEG_MAP[d[0]];                   // Thousands
+    d[1] = SEG_MAP[d[1]];                   // Hundreds
+    d[2] = SEG_MAP[d[2]];                   // Tens
+    d[3] = SEG_MAP[d[3]];                   // Units
+    SevenSeg_Load(d);
+}
+
+
+// Text
+
+// Encodes text into segment patterns, merging each '.' into the
+// previous character's decimal point. Returns the number written.
+static unsigned char SevenSeg_Encode(const char *text, unsigned char *out,
+                                     unsigned char max) {
+    unsigned char n = 0;
+    while (*text && n < max) {
+        unsigned char c = (unsigned char)*text++;
+        if (c == '.' && n && !(out[n - 1] & 0x80)) {
+            out[n - 1] |= 0x80;
+            continue;
+        }
+        out[n++] = (c >= 0x20 && c < 0x80) ? SEG_GLYPH[c - 0x20] : 0x00;
+    }
+    return n;
+}
+
+// Shows the first four characters, left aligned ("Err", "25.0*").
+void SevenSeg_Show_Text(const char *text) {
+    unsigned char p[4] = { 0, 0, 0, 0 };
+    SevenSeg_Encode(text, p, 4);
+    seg_value = 0xFFFF;              // next Update_Value always redraws
+    SevenSeg_Load(p);
+}
+
+// Shows a 16-bit value as four hex digits.
+void SevenSeg_Show_Hex(unsigned int value) {
+    unsigned char p[4];
+    for (signed char i = 3; i >= 0; i--) {
+        unsigned char d = value & 0x0F;
+        p[i] = SEG_GLYPH[(d < 10 ? '0' + d : 'A' - 10 + d) - 0x20];
+        value >>= 4;
+    }
+    seg_value = 0xFFFF;
+    SevenSeg_Load(p);
+}
+
+// Scrolls text of up to SEG_SCROLL_MAX characters right to left,
+// one step every frames_per_step scans (a scan is 4 ms), followed by
+// a blank gap, until the next Show/Update call.
+void SevenSeg_Scroll_Text(const char *text, unsigned char frames_per_step) {
+    seg_value = 0xFFFF;
+
+    // The ISR reads seg_scroll while scrolling; let it leave scroll
+    // mode (at most one scan) before the buffer is rewritten.
+    seg_mode_req = SEG_MODE_FRAME;
+    while (seg_mode == SEG_MODE_SCROLL && INTCONbits.GIE && INTCONbits.TMR0IE);
+    seg_mode = SEG_MODE_FRAME;
+
+    unsigned char n = SevenSeg_Encode(text, seg_scroll, SEG_SCROLL_MAX);
+    for (unsigned char i = 0; i < SEG_SCROLL_GAP; i++)
+        seg_scroll[n++] = 0x00;
+    for (unsigned char i = 0; i < 3; i++)
+        seg_scroll[n + i] = seg_scroll[i];
+
+    seg_scroll_len = n;
+    seg_scroll_pos = 0;
+    seg_scroll_count = 0;
+    seg_scroll_frames = frames_per_step ? frames_per_step : 1;
+    seg_mode_req = SEG_MODE_SCROLL;
 }
 
 
@@ -77,9 +229,26 @@ void SevenSeg_Update_Value(unsigned int number) {
 void SevenSeg_ISR_Handler(void) {
 
     LATA &= 0xF0; // Turn OFF all digits before updating
+
+    // Start of a scan: pick up a new frame or mode, step the scroll
+    if(current_digit == 0) {
+        if(seg_swap) {
+            seg_front ^= 1;
+            seg_swap = 0;
+        }
+        if(seg_mode_req != seg_mode) {
+            seg_mode = seg_mode_req;
+        } else if(seg_mode == SEG_MODE_SCROLL && ++seg_scroll_count >= seg_scroll_frames) {
+            seg_scroll_count = 0;
+            if(++seg_scroll_pos >= seg_scroll_len) seg_scroll_pos = 0;
+        }
+    }
     
     // Load segment pattern
-    LATD = digits[3 - current_digit];
+    if(seg_mode == SEG_MODE_SCROLL)
+        LATD = seg_scroll[seg_scroll_pos + 3 - current_digit];
+    else
+        LATD = seg_frame[seg_front][3 - current_digit];
 
     // Enable the active digit
     switch(current_digit) {
@@ -0,0 +1,130 @@
+#include "synth.h"
+
+
+// Phase increments, f * 65536 / SYNTH_RATE
+
+static const unsigned int SYNTH_INC[SYNTH_LAST - SYNTH_FIRST + 1] = {
+      923,   978,  1036,  1097,  1163,  1232,  1305,  1383,   // A2 .. E3
+     1465,  1552,  1644,  1742,  1845,  1955,  2071,  2195,   // F3 .. C4
+     2325,  2463,  2610,  2765,  2930,  3104,  3288,  3484,   // C#4 .. G#4
+     3691,  3910,  4143,  4389,  4650,  4927,  5220,  5530,   // A4 .. E5
+     5859,  6207,  6577,  6968,  7382,  7821,  8286,  8779,   // F5 .. C6
+     9301,  9854, 10440, 11060, 11718, 12415, 13153, 13935,   // C#6 .. G#6
+    14764, 15642, 16572, 17557,                               // A6 .. C7
+};
+
+
+// State
+
+static unsigned int syn_phase[SYNTH_VOICES];
+static unsigned int syn_inc[SYNTH_VOICES];
+static unsigned char syn_amp[SYNTH_VOICES];
+static unsigned char syn_decay[SYNTH_VOICES];
+static unsigned char syn_out;             // Duty for the next period
+static unsigned char syn_env;             // Samples to the envelope step
+static volatile unsigned char syn_busy;
+
+
+// Timer2 postscaled: one sample
+
+// The duty computed last time goes out first, so the output steps at
+// a fixed point of the interrupt whatever the mixing costs.
+void Synth_ISR_Handler(void) {
+    unsigned char out = 0, live = 0, v, a, d;
+
+    PIR1bits.TMR2IF = 0;
+    CCPR1L = syn_out >> 2;
+    CCP1CON = 0x0C | ((syn_out & 3) << 4);     // PWM, duty LSBs
+
+    for (v = 0; v < SYNTH_VOICES; v++) {
+        syn_phase[v] += syn_inc[v];
+        if (syn_phase[v] & 0x8000)
+            out += syn_amp[v];
+    }
+    syn_out = out;
+
+    if (--syn_env)
+        return;
+    syn_env = SYNTH_ENV_SAMPLES;
+    for (v = 0; v < SYNTH_VOICES; v++) {
+        a = syn_amp[v];
+        d = syn_decay[v];
+        if (a && d) {
+            d = a >> d;
+            a -= d ? d : 1;
+            syn_amp[v] = a;
+        }
+        live |= a;
+    }
+    if (!live)
+        Synth_Stop();
+}
+
+
+// Voices
+
+// The tick interrupt is masked while a voice changes under it.
+void Synth_Note(unsigned char voice, unsigned char note,
+                unsigned char level, unsigned char decay) {
+    if (voice >= SYNTH_VOICES || note < SYNTH_FIRST || note > SYNTH_LAST)
+        return;
+    if (level > SYNTH_LEVEL_MAX)
+        level = SYNTH_LEVEL_MAX;
+
+    PIE1bits.TMR2IE = 0;
+    syn_inc[voice] = SYNTH_INC[note - SYNTH_FIRST];
+    syn_amp[voice] = level;
+    syn_decay[voice] = decay;
+    if (!syn_busy && level) {
+        syn_out = 0;
+        syn_env = SYNTH_ENV_SAMPLES;
+        CCPR1L = 0;
+        CCP1CON = 0x0C;                   // PWM, 0% until the first sample
+        T2CON = 0x00;
+        T2CONbits.T2OUTPS = 8 - 1;        // Interrupt every 8th period
+        PR2 = 63;                         // 16 MHz / 4 / 64 = 62.5 kHz
+        TMR2 = 0;
+        PIR1bits.TMR2IF = 0;
+        T2CONbits.TMR2ON = 1;
+        syn_busy = 1;
+    }
+    PIE1bits.TMR2IE = 1;
+}
+
+void Synth_Release(unsigned char voice) {
+    if (voice < SYNTH_VOICES)
+        syn_decay[voice] = 1;
+}
+
+// Hands Timer2 back stopped, as Tone's 1 ms tick; leaves it alone
+// when idle, since Tone may be using it.
+void Synth_Stop(void) {
+    unsigned char v;
+
+    if (!syn_busy)
+        return;
+    T2CON = 0x02;                         // Stopped, 1:16
+    PR2 = 249;
+    PIR1bits.TMR2IF = 0;
+    CCP1CON = 0x00;                       // RC2 back to LATC2, low
+    for (v = 0; v < SYNTH_VOICES; v++)
+        syn_amp[v] = 0;
+    syn_busy = 0;
+}
+
+unsigned char Synth_Busy(void) {
+    return syn_busy;
+}
+
+
+// Initialisation
+
+void Synth_Init(void) {
+    ANSELCbits.ANSC2 = 0;
+    LATCbits.LATC2 = 0;
+    TRISCbits.TRISC2 = 0;
+    CCPTMRS0bits.C1TSEL = 0;              // CCP1 PWM on Timer2
+    PIE1bits.TMR2IE = 1;
+    INTCONbits.PEIE = 1;
+    syn_busy = 0;
+}
@@ -0,0 +1,311 @@
+#include "templog.h"
+
+
+// EEPROM layout
+
+// Block: two keyframe bytes holding an absolute T100 (7 bits each),
+// then TLOG_BLOCK - 2 symbol bytes. Bit 7 of every byte is the lap
+// bit: it flips each time the writer wraps to block 0, so bytes left
+// from the previous lap (or erased, 0xFF, before the first) are told
+// apart from the current ones without an index. Every block is
+// written to its last byte before the next one starts, which keeps
+// that true.
+//
+// Symbols, as 7-bit two's complement:
+//   -63..+62  delta from the previous sample
+//   -64       TLOG_ESC: the next two bytes are an absolute value
+//   +63       TLOG_PAD: no sample (fills a block an ESC cannot fit)
+#define TLOG_ESC 0x40
+#define TLOG_PAD 0x3F
+#define TLOG_LAP 0x80
+#define TLOG_NONE 0x3FFF              // keyframe of an erased block
+
+#define TLOG_Q_MASK (TLOG_QUEUE_SIZE - 1)
+
+
+// Write queue
+
+// Filled by TempLog_Add, drained by the EEPROM interrupt. The entry at
+// the tail stays queued until its write has finished.
+static unsigned char tlog_q_addr[TLOG_QUEUE_SIZE];
+static unsigned char tlog_q_data[TLOG_QUEUE_SIZE];
+static volatile unsigned char tlog_q_head;   // written by main loop
+static volatile unsigned char tlog_q_tail;   // written by ISR
+static volatile unsigned char tlog_busy;     // a write is in progress
+
+unsigned int tlog_dropped;                   // samples dropped, queue full
+
+// Writer position: next byte to write and the lap bit to write it with
+static unsigned char w_block, w_slot, w_lap;
+static unsigned int w_last;
+
+// Reader position (TempLog_Rewind / TempLog_Next)
+static unsigned char r_block, r_slot, r_left, r_lap, r_end;
+static unsigned int r_val;
+
+// Statistics
+static unsigned long st_count, st_sum;
+static unsigned int st_min, st_max;
+
+
+// Start the write at the queue tail (interrupts must be off)
+
+static void TempLog_Start(void) {
+    unsigned char t = tlog_q_tail;
+    EEADR = tlog_q_addr[t];
+    EEDATA = tlog_q_data[t];
+    EECON1 = 0x04;            // Data EEPROM, WREN
+    EECON2 = 0x55;            // Unlock sequence
+    EECON2 = 0xAA;
+    EECON1bits.WR = 1;
+    EECON1bits.WREN = 0;
+    tlog_busy = 1;
+}
+
+
+// EEPROM write finished: retire it and start the next
+
+void TempLog_ISR_Handler(void) {
+    PIR2bits.EEIF = 0;
+    tlog_q_tail = (tlog_q_tail + 1) & TLOG_Q_MASK;
+    tlog_busy = 0;
+    if (tlog_q_tail != tlog_q_head)
+        TempLog_Start();
+}
+
+unsigned char TempLog_Pending(void) {
+    return (tlog_q_head - tlog_q_tail) & TLOG_Q_MASK;
+}
+
+
+// Read one EEPROM byte
+
+// Holds the write interrupt off so EEADR stays ours, and lets a write
+// already in progress finish first.
+static unsigned char TempLog_Read_Byte(unsigned char addr) {
+    unsigned char ie = PIE2bits.EEIE;
+    PIE2bits.EEIE = 0;
+    while (EECON1bits.WR);
+    EEADR = addr;
+    EECON1 = 0x01;            // Data EEPROM, RD
+    unsigned char b = EEDATA;
+    PIE2bits.EEIE = ie;
+    return b;
+}
+
+
+// Queue the bytes of one sample at the writer position
+
+static void TempLog_Put(unsigned char payload) {
+    unsigned char h = tlog_q_head;
+    tlog_q_addr[h] = (unsigned char)(w_block * TLOG_BLOCK + w_slot);
+    tlog_q_data[h] = payload | w_lap;
+    tlog_q_head = (h + 1) & TLOG_Q_MASK;
+    if (++w_slot == TLOG_BLOCK) {
+        w_slot = 0;
+        if (++w_block == TLOG_BLOCKS) {
+            w_block = 0;
+            w_lap ^= TLOG_LAP;
+        }
+    }
+}
+
+static void TempLog_Stats(unsigned int t100) {
+    if (st_count == 0 || t100 < st_min) st_min = t100;
+    if (st_count == 0 || t100 > st_max) st_max = t100;
+    st_sum += t100;
+    if (++st_count == 0x40000UL) {     // keep st_sum in 32 bits
+        st_count >>= 1;
+        st_sum >>= 1;
+    }
+}
+
+
+// Log one sample
+
+// Worst case is two pads and a keyframe (four writes); if the queue
+// cannot take that the sample is dropped rather than half-written.
+void TempLog_Add(unsigned int t100) {
+
+    if (t100 > 9999) t100 = 9999;
+
+    int d = (int)t100 - (int)w_last;
+    unsigned char free = TLOG_Q_MASK - TempLog_Pending();
+
+    if (free < 4) {
+        tlog_dropped++;
+        return;
+    }
+
+    if (w_slot != 0 && d >= -63 && d <= 62) {
+        TempLog_Put((unsigned char)d & 0x7F);
+    } else {
+        if (w_slot != 0 && w_slot > TLOG_BLOCK - 3) {
+            while (w_slot != 0)          // ESC does not fit: next block
+                TempLog_Put(TLOG_PAD);
+        }
+        if (w_slot != 0)
+            TempLog_Put(TLOG_ESC);
+        TempLog_Put((unsigned char)(t100 >> 7));
+        TempLog_Put((unsigned char)(t100 & 0x7F));
+    }
+    w_last = t100;
+    TempLog_Stats(t100);
+
+    // Start the queue unless the interrupt is already draining it
+    unsigned char gie = INTCONbits.GIE;
+    INTCONbits.GIE = 0;
+    if (!tlog_busy)
+        TempLog_Start();
+    INTCONbits.GIE = gie;
+}
+
+
+// Readout
+
+// The oldest block is the one after the writer's, or the writer's own
+// if it has not been started this lap. Queued writes are waited for
+// (interrupts must be on) so the EEPROM is consistent.
+void TempLog_Rewind(void) {
+    while (TempLog_Pending())
+        HAL_IDLE();
+    r_block = w_slot ? (w_block + 1) % TLOG_BLOCKS : w_block;
+    r_left = TLOG_BLOCKS;
+    r_slot = 0;
+}
+
+static void TempLog_Next_Block(void) {
+    r_end = r_slot;
+    r_slot = 0;
+    r_block = (r_block + 1) % TLOG_BLOCKS;
+    r_left--;
+}
+
+unsigned char TempLog_Next(unsigned int *t100) {
+
+    unsigned char base, b, h, l;
+
+    while (r_left) {
+        base = (unsigned char)(r_block * TLOG_BLOCK);
+        if (r_slot == 0) {                     // keyframe
+            h = TempLog_Read_Byte(base);
+            l = TempLog_Read_Byte(base + 1);
+            r_lap = h & TLOG_LAP;
+            r_val = ((unsigned int)(h & 0x7F) << 7) | (l & 0x7F);
+            if ((l & TLOG_LAP) != r_lap || r_val > 9999) {
+                TempLog_Next_Block();          // erased or half-written
+                continue;
+            }
+            r_slot = 2;
+            *t100 = r_val;
+            return 1;
+        }
+        if (r_slot >= TLOG_BLOCK) {
+            TempLog_Next_Block();
+            continue;
+        }
+        b = TempLog_Read_Byte(base + r_slot);
+        if ((b & TLOG_LAP) != r_lap) {         // not written this lap
+            TempLog_Next_Block();
+            continue;
+        }
+        b &= 0x7F;
+        if (b == TLOG_PAD) {
+            r_slot++;
+            continue;
+        }
+        if (b == TLOG_ESC) {
+            if (r_slot > TLOG_BLOCK - 3) { TempLog_Next_Block(); continue; }
+            h = TempLog_Read_Byte(base + r_slot + 1);
+            l = TempLog_Read_Byte(base + r_slot + 2);
+            if ((h & TLOG_LAP) != r_lap || (l & TLOG_LAP) != r_lap) {
+                TempLog_Next_Block();          // ESC without its value
+                continue;
+            }
+            r_val = ((unsigned int)(h & 0x7F) << 7) | (l & 0x7F);
+            r_slot += 3;
+        } else {
+            r_val += (b & 0x40) ? (int)b - 128 : (int)b;
+            r_slot++;
+        }
+        *t100 = r_val;
+        return 1;
+    }
+    return 0;
+}
+
+
+// Power-up: find where the last run stopped
+
+// Blocks written in the current lap share block 0's lap bit; the
+// newest is the last of them. It is read through to find its end and
+// last value, and the writer carries on from there. With no valid
+// keyframe anywhere the EEPROM is treated as empty.
+void TempLog_Init(void) {
+
+    unsigned char i, lap, newest, any = 0;
+    unsigned int t;
+
+    tlog_q_head = 0;
+    tlog_q_tail = 0;
+    tlog_busy = 0;
+    tlog_dropped = 0;
+    st_count = 0;
+    st_sum = 0;
+
+    lap = TempLog_Read_Byte(0) & TLOG_LAP;
+    for (i = 1; i < TLOG_BLOCKS; i++)
+        if ((TempLog_Read_Byte((unsigned char)(i * TLOG_BLOCK)) & TLOG_LAP) != lap)
+            break;
+    newest = i - 1;
+
+    for (i = 0; i < TLOG_BLOCKS && !any; i++) {
+        r_block = i;
+        r_left = 1;
+        r_slot = 0;
+        any = TempLog_Next(&t);
+    }
+
+    if (!any) {
+        w_block = 0;
+        w_slot = 0;
+        w_lap = 0;                       // erased bytes carry lap bit 1
+    } else {
+        w_block = newest;
+        w_lap = lap;
+        r_block = newest;
+        r_left = 1;
+        r_slot = 0;
+        r_end = 0;
+        while (TempLog_Next(&t))
+            ;
+        w_slot = r_end;
+        w_last = r_val;
+        if (w_slot == TLOG_BLOCK) {
+            w_slot = 0;
+            if (++w_block == TLOG_BLOCKS) {
+                w_block = 0;
+                w_lap ^= TLOG_LAP;
+            }
+        }
+    }
+
+    TempLog_Rewind();                    // rebuild the statistics
+    while (TempLog_Next(&t))
+        TempLog_Stats(t);
+
+    PIR2bits.EEIF = 0;
+    PIE2bits.EEIE = 1;
+    INTCONbits.PEIE = 1;
+}
+
+
+// Statistics
+
+unsigned long TempLog_Count(void) { return st_count; }
+unsigned int TempLog_Min(void) { return st_min; }
+unsigned int TempLog_Max(void) { return st_max; }
+
+unsigned int TempLog_Mean(void) {
+    return st_count ? (unsigned int)((st_sum + st_count / 2) / st_count) : 0;
+}
@@ -0,0 +1,109 @@
+#include "tone.h"
+
+
+// Half periods in Timer1 counts (250 ns), 2 MHz / f
+
+static const unsigned int TONE_HALF[TONE_LAST - TONE_FIRST + 1] = {
+    18182, 17161, 16198, 15289, 14431, 13621, 12856, 12135,   // A2 .. E3
+    11454, 10811, 10204,  9631,  9091,  8581,  8099,  7645,   // F3 .. C4
+     7215,  6810,  6428,  6067,  5727,  5405,  5102,  4816,   // C#4 .. G#4
+     4545,  4290,  4050,  3822,  3608,  3405,  3214,  3034,   // A4 .. E5
+     2863,  2703,  2551,  2408,  2273,  2145,  2025,  1911,   // F5 .. C6
+     1804,  1703,  1607,  1517,  1432,  1351,  1276,  1204,   // C#6 .. G#6
+     1136,  1073,  1012,   956,   902,   851,   804,   758,   // A6 .. E7
+      716,   676,   638,   602,   568,   536,   506,   478,   // F7 .. C8
+};
+
+
+// State
+
+static unsigned int tone_half;            // Current half period
+static unsigned int tone_next;            // CCPR1 of the next edge
+static volatile unsigned int tone_ms;     // Left of the note, 0 = held
+static volatile unsigned char tone_busy;
+
+
+// CCP1 compare: RC2 has just toggled, schedule the next edge
+
+void Tone_ISR_Handler(void) {
+    PIR1bits.CCP1IF = 0;
+    tone_next += tone_half;
+    CCPR1L = (unsigned char)tone_next;
+    CCPR1H = (unsigned char)(tone_next >> 8);
+}
+
+
+// Timer2, 1 ms: count down the duration
+
+void Tone_Tick_Handler(void) {
+    PIR1bits.TMR2IF = 0;
+    if (--tone_ms == 0)
+        Tone_Stop();
+}
+
+
+// Start a note
+
+// The first edge is one half period from now. A note outside the
+// table plays as a rest.
+void Tone_Play(unsigned char note, unsigned int ms) {
+    unsigned char l, h;
+
+    PIE1bits.CCP1IE = 0;
+    T2CONbits.TMR2ON = 0;
+    CCP1CON = 0x00;                       // RC2 low between notes
+
+    if (note >= TONE_FIRST && note <= TONE_LAST) {
+        tone_half = TONE_HALF[note - TONE_FIRST];
+        l = TMR1L;                        // latches TMR1H
+        h = TMR1H;
+        tone_next = (((unsigned int)h << 8) | l) + tone_half;
+        CCPR1L = (unsigned char)tone_next;
+        CCPR1H = (unsigned char)(tone_next >> 8);
+        CCP1CON = 0x02;                   // Compare: toggle RC2 on match
+        PIR1bits.CCP1IF = 0;
+        PIE1bits.CCP1IE = 1;
+    }
+
+    tone_ms = ms;
+    tone_busy = 1;
+    if (ms) {
+        TMR2 = 0;
+        PIR1bits.TMR2IF = 0;
+        T2CONbits.TMR2ON = 1;
+    }
+}
+
+void Tone_Stop(void) {
+    PIE1bits.CCP1IE = 0;
+    CCP1CON = 0x00;
+    T2CONbits.TMR2ON = 0;
+    tone_busy = 0;
+}
+
+unsigned char Tone_Busy(void) {
+    return tone_busy;
+}
+
+
+// Initialisation
+
+// Timer1 runs free at Fosc/4 (CCP1 only compares against it, so it can
+// be shared); Timer2 is 1:16 with PR2 = 249, 1 ms per interrupt.
+void Tone_Init(void) {
+    ANSELCbits.ANSC2 = 0;
+    LATCbits.LATC2 = 0;
+    TRISCbits.TRISC2 = 0;
+
+    T1CON = 0x03;                         // Fosc/4, 1:1, 16-bit reads, on
+    CCPTMRS0bits.C1TSEL = 0;              // CCP1 on Timer1/Timer2
+    CCP1CON = 0x00;
+
+    T2CON = 0x00;
+    T2CONbits.T2CKPS = 2;                 // 1:16
+    PR2 = 249;
+    PIR1bits.TMR2IF = 0;
+    PIE1bits.TMR2IE = 1;
+    INTCONbits.PEIE = 1;
+    tone_busy = 0;
+}
@@ -0,0 +1,57 @@
+#ifndef ADC_H
+#define ADC_H
+
+#include "hal.h"
+
+// Free-running acquisition engine
+
+// Timer3 and the CCP5 special event trigger start a conversion at a
+// fixed rate (the scan tick). Sampling is covered by the hardware
+// acquisition time (ADCON2.ACQT), so no software delay or polling is
+// involved. On each tick the ADC interrupt converts every scan entry
+// that is due back-to-back: it switches CHS and sets GO straight
+// away, and ACQT gives the new channel its acquisition time.
+
+// Oversampling: with extra_bits = 1, 2 or 3 an entry sums 4, 16 or 64
+// conversions and shifts the sum right by extra_bits, giving one 11,
+// 12 or 13-bit sample. This needs about 1 LSB of noise on the input
+// (the LM35 and the supply provide it), otherwise every conversion is
+// the same code and the extra bits stay zero.
+
+#define ADC_RING_SIZE 16              // Power of two
+#define ADC_MAX_EXTRA_BITS 3          // 64x
+#define ADC_SCAN_MAX 4                // Entries in a scan table
+#define ADC_AVG_SHIFT 3               // ADC_Average weights new samples 1/8
+
+// One scan table entry. rate_hz is samples per second after
+// decimation. done, if set, is called from the interrupt with each
+// sample; ADC_Queue puts them in the ring read by ADC_Read.
+typedef struct {
+    unsigned char channel;            // CHS code: 0..27 = ANx, 31 = FVR
+    unsigned char extra_bits;         // 0..ADC_MAX_EXTRA_BITS
+    unsigned int rate_hz;
+    void (*done)(unsigned int sample);
+} adc_scan_t;
+
+// The tick runs at the fastest entry's conversion rate (at most about
+// 20000/s, and each tick must fit every due conversion at 38 us each).
+// Slower entries are converted every Nth tick. The table must stay
+// valid while scanning.
+void ADC_Scan_Start(const adc_scan_t *table, unsigned char entries);
+void ADC_Start(unsigned char channel, unsigned int rate_hz, unsigned char extra_bits);  // One entry into the ring
+void ADC_Stop(void);
+void ADC_ISR_Handler(void);            // Call on PIR1bits.ADIF
+
+// Per entry, never blocking
+unsigned int ADC_Latest(unsigned char entry);   // Newest sample
+unsigned int ADC_Average(unsigned char entry);  // Exponential average, same scale
+unsigned int ADC_Rate_Hz(unsigned char entry);  // Sample rate actually programmed
+
+// Sample ring, fed by entries whose done is ADC_Queue
+void ADC_Queue(unsigned int sample);
+unsigned char ADC_Available(void);     // Samples waiting in the ring
+unsigned char ADC_Read(unsigned int *sample);   // 1 = sample taken, 0 = ring empty
+unsigned long ADC_Sample_Count(void);  // Samples queued since the scan started
+unsigned int ADC_Dropped(void);        // Samples lost because the ring was full
+
+#endif
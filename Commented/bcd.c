@@ -0,0 +1,23 @@
+#include "bcd.h"
+
+
+// Binary to BCD by reciprocal multiplication
+
+// The PIC18 has no divider, but it has an 8x8 hardware multiplier, so
+// dividing by a constant is done as a multiply and a shift:
+//   v / 100 == (v * 5243) >> 19   for v <= 43698
+//   x / 10  == (x * 205)  >> 11   for x <= 1028
+// The first needs one 16x16 multiply, each pair of digits then only
+// an 8x8 one. bench/check_host.c checks it against / and % for every
+// value 0..9999 in the default build.
+void bin_to_bcd4(unsigned int v, unsigned char d[4]) {
+    if (v > 9999) v = 9999;
+
+    unsigned char hi = (unsigned char)(((unsigned long)v * 5243u) >> 19);
+    unsigned char lo = (unsigned char)(v - (unsigned int)hi * 100u);
+
+    d[0] = (unsigned char)(((unsigned int)hi * 205u) >> 11);
+    d[1] = (unsigned char)(hi - d[0] * 10u);
+    d[2] = (unsigned char)(((unsigned int)lo * 205u) >> 11);
+    d[3] = (unsigned char)(lo - d[2] * 10u);
+}
@@ -0,0 +1,10 @@
+#ifndef BCD_H
+#define BCD_H
+
+#include "hal.h"
+
+// Split 0..9999 into four decimal digits, thousands first.
+// Values above 9999 are clamped.
+void bin_to_bcd4(unsigned int v, unsigned char d[4]);
+
+#endif
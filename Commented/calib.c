@@ -0,0 +1,38 @@
+#include "calib.h"
+
+
+// Calibration table, in flash
+
+// calib_5v.h / calib_3v3.h are the ideal LM35 line for each supply.
+// A board-specific table from tools/calgen.py replaces them when the
+// build defines CAL_TABLE as its header name.
+#if defined(CAL_TABLE)
+#include CAL_TABLE
+#elif VREF_mV == 3300
+#include "calib_3v3.h"
+#else
+#include "calib_5v.h"
+#endif
+
+#if CAL_VREF_mV != VREF_mV
+#error "The calibration table was generated for a different VREF_mV"
+#endif
+
+
+// Table read, plus one multiply for the oversampled bits
+
+// Entries rise by well under 256 per code, so the step times a
+// fraction of at most 7 stays in 16 bits.
+unsigned int cal_T100(unsigned int code, unsigned char extra_bits) {
+
+    unsigned int i = code >> extra_bits;
+    if (i >= CAL_CODES)
+        return CAL_T100[CAL_CODES];
+
+    unsigned int t = CAL_T100[i];
+    if (extra_bits) {
+        unsigned char frac = (unsigned char)(code & ((1u << extra_bits) - 1));
+        t += ((CAL_T100[i + 1] - t) * frac) >> extra_bits;
+    }
+    return t;
+}
@@ -0,0 +1,20 @@
+#ifndef CALIB_H
+#define CALIB_H
+
+#include "hal.h"
+
+// ADC reference: the board supply, 5 V or 3.3 V with J5.
+// Set at build time (CMake: -DVREF_mV=3300).
+#ifndef VREF_mV
+#define VREF_mV 5000u
+#endif
+
+#define CAL_CODES 512        // Table covers 10-bit codes 0..CAL_CODES
+
+// ADC code to LM35 temperature in hundredths of a degree, through the
+// calibration table (tools/calgen.py). extra_bits (0..3) is the number
+// of oversampled bits below the 10-bit code; they interpolate between
+// table entries. Codes past the table return its last entry.
+unsigned int cal_T100(unsigned int code, unsigned char extra_bits);
+
+#endif
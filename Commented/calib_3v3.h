@@ -0,0 +1,49 @@
+// Generated by tools/calgen.py --vref 3300
+// Do not edit; rerun the generator instead.
+#define CAL_VREF_mV 3300
+
+static const unsigned int CAL_T100[CAL_CODES + 1] = {
+        0,    32,    64,    97,   129,   161,   193,   226,   258,   290,   322,   354,
+      387,   419,   451,   483,   516,   548,   580,   612,   645,   677,   709,   741,
+      773,   806,   838,   870,   902,   935,   967,   999,  1031,  1063,  1096,  1128,
+     1160,  1192,  1225,  1257,  1289,  1321,  1354,  1386,  1418,  1450,  1482,  1515,
+     1547,  1579,  1611,  1644,  1676,  1708,  1740,  1772,  1805,  1837,  1869,  1901,
+     1934,  1966,  1998,  2030,  2062,  2095,  2127,  2159,  2191,  2224,  2256,  2288,
+     2320,  2353,  2385,  2417,  2449,  2481,  2514,  2546,  2578,  2610,  2643,  2675,
+     2707,  2739,  2771,  2804,  2836,  2868,  2900,  2933,  2965,  2997,  3029,  3062,
+     3094,  3126,  3158,  3190,  3223,  3255,  3287,  3319,  3352,  3384,  3416,  3448,
+     3480,  3513,  3545,  3577,  3609,  3642,  3674,  3706,  3738,  3771,  3803,  3835,
+     3867,  3899,  3932,  3964,  3996,  4028,  4061,  4093,  4125,  4157,  4189,  4222,
+     4254,  4286,  4318,  4351,  4383,  4415,  4447,  4479,  4512,  4544,  4576,  4608,
+     4641,  4673,  4705,  4737,  4770,  4802,  4834,  4866,  4898,  4931,  4963,  4995,
+     5027,  5060,  5092,  5124,  5156,  5188,  5221,  5253,  5285,  5317,  5350,  5382,
+     5414,  5446,  5479,  5511,  5543,  5575,  5607,  5640,  5672,  5704,  5736,  5769,
+     5801,  5833,  5865,  5897,  5930,  5962,  5994,  6026,  6059,  6091,  6123,  6155,
+     6188,  6220,  6252,  6284,  6316,  6349,  6381,  6413,  6445,  6478,  6510,  6542,
+     6574,  6606,  6639,  6671,  6703,  6735,  6768,  6800,  6832,  6864,  6896,  6929,
+     6961,  6993,  7025,  7058,  7090,  7122,  7154,  7187,  7219,  7251,  7283,  7315,
+     7348,  7380,  7412,  7444,  7477,  7509,  7541,  7573,  7605,  7638,  7670,  7702,
+     7734,  7767,  7799,  7831,  7863,  7896,  7928,  7960,  7992,  8024,  8057,  8089,
+     8121,  8153,  8186,  8218,  8250,  8282,  8314,  8347,  8379,  8411,  8443,  8476,
+     8508,  8540,  8572,  8604,  8637,  8669,  8701,  8733,  8766,  8798,  8830,  8862,
+     8895,  8927,  8959,  8991,  9023,  9056,  9088,  9120,  9152,  9185,  9217,  9249,
+     9281,  9313,  9346,  9378,  9410,  9442,  9475,  9507,  9539,  9571,  9604,  9636,
+     9668,  9700,  9732,  9765,  9797,  9829,  9861,  9894,  9926,  9958,  9990, 10022,
+    10055, 10087, 10119, 10151, 10184, 10216, 10248, 10280, 10312, 10345, 10377, 10409,
+    10441, 10474, 10506, 10538, 10570, 10603, 10635, 10667, 10699, 10731, 10764, 10796,
+    10828, 10860, 10893, 10925, 10957, 10989, 11021, 11054, 11086, 11118, 11150, 11183,
+    11215, 11247, 11279, 11312, 11344, 11376, 11408, 11440, 11473, 11505, 11537, 11569,
+    11602, 11634, 11666, 11698, 11730, 11763, 11795, 11827, 11859, 11892, 11924, 11956,
+    11988, 12021, 12053, 12085, 12117, 12149, 12182, 12214, 12246, 12278, 12311, 12343,
+    12375, 12407, 12439, 12472, 12504, 12536, 12568, 12601, 12633, 12665, 12697, 12729,
+    12762, 12794, 12826, 12858, 12891, 12923, 12955, 12987, 13020, 13052, 13084, 13116,
+    13148, 13181, 13213, 13245, 13277, 13310, 13342, 13374, 13406, 13438, 13471, 13503,
+    13535, 13567, 13600, 13632, 13664, 13696, 13729, 13761, 13793, 13825, 13857, 13890,
+    13922, 13954, 13986, 14019, 14051, 14083, 14115, 14147, 14180, 14212, 14244, 14276,
+    14309, 14341, 14373, 14405, 14438, 14470, 14502, 14534, 14566, 14599, 14631, 14663,
+    14695, 14728, 14760, 14792, 14824, 14856, 14889, 14921, 14953, 14985, 15018, 15050,
+    15082, 15114, 15146, 15179, 15211, 15243, 15275, 15308, 15340, 15372, 15404, 15437,
+    15469, 15501, 15533, 15565, 15598, 15630, 15662, 15694, 15727, 15759, 15791, 15823,
+    15855, 15888, 15920, 15952, 15984, 16017, 16049, 16081, 16113, 16146, 16178, 16210,
+    16242, 16274, 16307, 16339, 16371, 16403, 16436, 16468, 16500
+};
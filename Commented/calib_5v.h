@@ -0,0 +1,49 @@
+// Generated by tools/calgen.py --vref 5000
+// Do not edit; rerun the generator instead.
+#define CAL_VREF_mV 5000
+
+static const unsigned int CAL_T100[CAL_CODES + 1] = {
+        0,    49,    98,   146,   195,   244,   293,   342,   391,   439,   488,   537,
+      586,   635,   684,   732,   781,   830,   879,   928,   977,  1025,  1074,  1123,
+     1172,  1221,  1270,  1318,  1367,  1416,  1465,  1514,  1562,  1611,  1660,  1709,
+     1758,  1807,  1855,  1904,  1953,  2002,  2051,  2100,  2148,  2197,  2246,  2295,
+     2344,  2393,  2441,  2490,  2539,  2588,  2637,  2686,  2734,  2783,  2832,  2881,
+     2930,  2979,  3027,  3076,  3125,  3174,  3223,  3271,  3320,  3369,  3418,  3467,
+     3516,  3564,  3613,  3662,  3711,  3760,  3809,  3857,  3906,  3955,  4004,  4053,
+     4102,  4150,  4199,  4248,  4297,  4346,  4395,  4443,  4492,  4541,  4590,  4639,
+     4688,  4736,  4785,  4834,  4883,  4932,  4980,  5029,  5078,  5127,  5176,  5225,
+     5273,  5322,  5371,  5420,  5469,  5518,  5566,  5615,  5664,  5713,  5762,  5811,
+     5859,  5908,  5957,  6006,  6055,  6104,  6152,  6201,  6250,  6299,  6348,  6396,
+     6445,  6494,  6543,  6592,  6641,  6689,  6738,  6787,  6836,  6885,  6934,  6982,
+     7031,  7080,  7129,  7178,  7227,  7275,  7324,  7373,  7422,  7471,  7520,  7568,
+     7617,  7666,  7715,  7764,  7812,  7861,  7910,  7959,  8008,  8057,  8105,  8154,
+     8203,  8252,  8301,  8350,  8398,  8447,  8496,  8545,  8594,  8643,  8691,  8740,
+     8789,  8838,  8887,  8936,  8984,  9033,  9082,  9131,  9180,  9229,  9277,  9326,
+     9375,  9424,  9473,  9521,  9570,  9619,  9668,  9717,  9766,  9814,  9863,  9912,
+     9961, 10010, 10059, 10107, 10156, 10205, 10254, 10303, 10352, 10400, 10449, 10498,
+    10547, 10596, 10645, 10693, 10742, 10791, 10840, 10889, 10938, 10986, 11035, 11084,
+    11133, 11182, 11230, 11279, 11328, 11377, 11426, 11475, 11523, 11572, 11621, 11670,
+    11719, 11768, 11816, 11865, 11914, 11963, 12012, 12061, 12109, 12158, 12207, 12256,
+    12305, 12354, 12402, 12451, 12500, 12549, 12598, 12646, 12695, 12744, 12793, 12842,
+    12891, 12939, 12988, 13037, 13086, 13135, 13184, 13232, 13281, 13330, 13379, 13428,
+    13477, 13525, 13574, 13623, 13672, 13721, 13770, 13818, 13867, 13916, 13965, 14014,
+    14062, 14111, 14160, 14209, 14258, 14307, 14355, 14404, 14453, 14502, 14551, 14600,
+    14648, 14697, 14746, 14795, 14844, 14893, 14941, 14990, 15039, 15088, 15137, 15186,
+    15234, 15283, 15332, 15381, 15430, 15479, 15527, 15576, 15625, 15674, 15723, 15771,
+    15820, 15869, 15918, 15967, 16016, 16064, 16113, 16162, 16211, 16260, 16309, 16357,
+    16406, 16455, 16504, 16553, 16602, 16650, 16699, 16748, 16797, 16846, 16895, 16943,
+    16992, 17041, 17090, 17139, 17188, 17236, 17285, 17334, 17383, 17432, 17480, 17529,
+    17578, 17627, 17676, 17725, 17773, 17822, 17871, 17920, 17969, 18018, 18066, 18115,
+    18164, 18213, 18262, 18311, 18359, 18408, 18457, 18506, 18555, 18604, 18652, 18701,
+    18750, 18799, 18848, 18896, 18945, 18994, 19043, 19092, 19141, 19189, 19238, 19287,
+    19336, 19385, 19434, 19482, 19531, 19580, 19629, 19678, 19727, 19775, 19824, 19873,
+    19922, 19971, 20020, 20068, 20117, 20166, 20215, 20264, 20312, 20361, 20410, 20459,
+    20508, 20557, 20605, 20654, 20703, 20752, 20801, 20850, 20898, 20947, 20996, 21045,
+    21094, 21143, 21191, 21240, 21289, 21338, 21387, 21436, 21484, 21533, 21582, 21631,
+    21680, 21729, 21777, 21826, 21875, 21924, 21973, 22021, 22070, 22119, 22168, 22217,
+    22266, 22314, 22363, 22412, 22461, 22510, 22559, 22607, 22656, 22705, 22754, 22803,
+    22852, 22900, 22949, 22998, 23047, 23096, 23145, 23193, 23242, 23291, 23340, 23389,
+    23438, 23486, 23535, 23584, 23633, 23682, 23730, 23779, 23828, 23877, 23926, 23975,
+    24023, 24072, 24121, 24170, 24219, 24268, 24316, 24365, 24414, 24463, 24512, 24561,
+    24609, 24658, 24707, 24756, 24805, 24854, 24902, 24951, 25000
+};
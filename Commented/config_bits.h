@@ -0,0 +1,10 @@
+#ifndef CONFIG_BITS_H
+#define CONFIG_BITS_H
+
+#include "hal.h"
+
+// Oscillator frequency used by __delay_ms / __delay_us.
+// The #pragma config settings live in main.c (one translation unit only).
+#define _XTAL_FREQ 16000000UL
+
+#endif
@@ -0,0 +1,36 @@
+#ifndef DEBOUNCE_H
+#define DEBOUNCE_H
+
+#include "hal.h"
+
+// Debounced buttons on PORTB
+
+// Timer6 samples PORTB every DEBOUNCE_TICK_MS. A pin changes its
+// debounced state once it has read the same for four ticks in a row,
+// all eight pins at once with 2-bit vertical counters. Buttons are
+// active low (pressed = 0); a press or release is latched in an event
+// mask until the main loop takes it, so nothing waits.
+//
+// Debounce_Edge lets a pin-change interrupt report an edge at once
+// instead of four ticks later; the pin then ignores further edges for
+// three ticks while it bounces.
+
+#define DEBOUNCE_TICK_MS 5            // 1..16; settles after 4 ticks
+
+void Debounce_Init(unsigned char pins);   // PORTB pins that are buttons
+void Debounce_ISR_Handler(void);          // Call on PIR5bits.TMR6IF
+
+// Without Timer6 (e.g. when the scheduler has it): call Debounce_Tick
+// every DEBOUNCE_TICK_MS from a task instead, and not Debounce_Edge.
+void Debounce_Init_Polled(unsigned char pins);
+void Debounce_Tick(void);
+void Debounce_Edge(unsigned char pins);   // From an INTx / IOC interrupt
+
+// Events for the pins in mask since the last call, cleared when taken
+unsigned char Debounce_Pressed(unsigned char mask);
+unsigned char Debounce_Released(unsigned char mask);
+unsigned char Debounce_Held(void);     // Debounced state, 1 = pressed
+unsigned char Debounce_Busy(void);     // Pins still settling: keep ticking
+unsigned char Debounce_Pending(void);  // Presses latched, not yet taken
+
+#endif
@@ -0,0 +1,105 @@
+#include "filter.h"
+
+
+// Set up a filter; it starts from the first sample pushed
+
+void filter_init(filter_t *f, unsigned char kind, unsigned char param) {
+    if (kind == FILTER_BOXCAR && param > 4) param = 4;
+    if (kind == FILTER_IIR && param > 8) param = 8;
+    if (kind == FILTER_MEDIAN && param != 3 && param != 5) param = 7;
+    f->kind = kind;
+    f->param = param;
+    f->pos = 0;
+    f->primed = 0;
+    f->acc = 0;
+    f->out = 0;
+}
+
+
+// Boxcar: running sum over a power-of-two window
+
+// The oldest sample leaves the sum as the new one enters, and the
+// mean is a shift.
+static void filter_boxcar(filter_t *f, unsigned int x) {
+    unsigned char n = (unsigned char)(1u << f->param);
+    if (!f->primed) {
+        for (unsigned char i = 0; i < n; i++)
+            f->buf[i] = x;
+        f->acc = (unsigned long)x << f->param;
+    }
+    f->acc += x;
+    f->acc -= f->buf[f->pos];
+    f->buf[f->pos] = x;
+    f->pos = (f->pos + 1) & (n - 1);
+    f->out = (unsigned int)((f->acc + (n >> 1)) >> f->param);
+}
+
+
+// Single-pole IIR, state kept with param fraction bits
+
+static void filter_iir(filter_t *f, unsigned int x) {
+    if (!f->primed)
+        f->acc = (unsigned long)x << f->param;
+    f->acc -= f->acc >> f->param;
+    f->acc += x;
+    f->out = (unsigned int)((f->acc + ((1UL << f->param) >> 1)) >> f->param);
+}
+
+
+// Median of 3, 5 or 7: a fixed compare-exchange network
+
+// The window is copied and partly sorted by a sorting network,
+// so the number of compares depends only on the window size.
+#define FILTER_CX(a, b) if (w[a] > w[b]) { unsigned int t_ = w[a]; w[a] = w[b]; w[b] = t_; }
+
+static void filter_median(filter_t *f, unsigned int x) {
+    unsigned char n = f->param;
+    unsigned int w[7];
+    if (!f->primed) {
+        for (unsigned char i = 0; i < n; i++)
+            f->buf[i] = x;
+    }
+    f->buf[f->pos] = x;
+    if (++f->pos == n) f->pos = 0;
+    for (unsigned char i = 0; i < n; i++)
+        w[i] = f->buf[i];
+
+    if (n == 3) {
+        FILTER_CX(0, 1) FILTER_CX(1, 2) FILTER_CX(0, 1)
+        f->out = w[1];
+    } else if (n == 5) {
+        FILTER_CX(0, 1) FILTER_CX(3, 4) FILTER_CX(0, 3) FILTER_CX(1, 4)
+        FILTER_CX(1, 2) FILTER_CX(2, 3) FILTER_CX(1, 2)
+        f->out = w[2];
+    } else {
+        FILTER_CX(0, 5) FILTER_CX(0, 3) FILTER_CX(1, 6) FILTER_CX(2, 4)
+        FILTER_CX(0, 1) FILTER_CX(3, 5) FILTER_CX(2, 6) FILTER_CX(2, 3)
+        FILTER_CX(3, 6) FILTER_CX(4, 5) FILTER_CX(1, 4) FILTER_CX(1, 3)
+        FILTER_CX(3, 4)
+        f->out = w[3];
+    }
+}
+
+
+// Hysteresis: hold the output until the input moves far enough
+
+static void filter_hyst(filter_t *f, unsigned int x) {
+    unsigned int d = x > f->out ? x - f->out : f->out - x;
+    if (!f->primed || d > f->param)
+        f->out = x;
+}
+
+
+void filter_push(filter_t *f, unsigned int x) {
+    switch (f->kind) {
+    case FILTER_BOXCAR: filter_boxcar(f, x); break;
+    case FILTER_IIR:    filter_iir(f, x);    break;
+    case FILTER_MEDIAN: filter_median(f, x); break;
+    default:            filter_hyst(f, x);   break;
+    }
+    f->primed = 1;
+}
+
+unsigned int filter_value(const filter_t *f) {
+    return f->out;
+}
@@ -0,0 +1,40 @@
+#ifndef FILTER_H
+#define FILTER_H
+
+#include "hal.h"
+
+// Integer smoothing filters behind one interface
+
+// filter_push() does all the work for a new sample in a fixed number of
+// steps (no division, no loop whose length depends on the data);
+// filter_value() only returns the stored output. The first sample
+// primes the state, so there is no ramp up from zero.
+//
+//   FILTER_BOXCAR  mean of the last 2^param samples (param 0..4)
+//   FILTER_IIR     y += (x - y) / 2^param, exponential smoothing
+//                  (param 0..8)
+//   FILTER_MEDIAN  median of the last param samples (3, 5 or 7)
+//   FILTER_HYST    y follows x only once they differ by more than param
+
+#define FILTER_BOXCAR 0
+#define FILTER_IIR    1
+#define FILTER_MEDIAN 2
+#define FILTER_HYST   3
+
+#define FILTER_TAPS 16                // Largest boxcar window
+
+typedef struct {
+    unsigned char kind;
+    unsigned char param;
+    unsigned char pos;                // next slot in buf
+    unsigned char primed;
+    unsigned long acc;                // boxcar sum, IIR state << param
+    unsigned int out;
+    unsigned int buf[FILTER_TAPS];
+} filter_t;
+
+void filter_init(filter_t *f, unsigned char kind, unsigned char param);
+void filter_push(filter_t *f, unsigned int x);
+unsigned int filter_value(const filter_t *f);
+
+#endif
@@ -0,0 +1,125 @@
+#include "fmt.h"
+#include "bcd.h"
+
+
+// Decimal digits without division
+
+// The PIC18 has no divide instruction: the ten-thousands digit is
+// peeled off by subtraction (at most 6 times) and the rest comes from
+// bin_to_bcd4, shared with the seven-segment driver.
+
+// Writes the 5 digits of v (with leading zeros) to d and returns how
+// many are significant (at least 1).
+static unsigned char Fmt_Digits(char *d, unsigned int v) {
+    char c = '0';
+    while (v >= 10000) {
+        v -= 10000;
+        c++;
+    }
+    d[0] = c;
+    bin_to_bcd4(v, (unsigned char *)d + 1);
+
+    unsigned char n = 0;
+    for (unsigned char i = 0; i < 5; i++) {
+        if (i)
+            d[i] += '0';
+        if (d[i] != '0' && n == 0)
+            n = 5 - i;
+    }
+    return n ? n : 1;
+}
+
+static char *Fmt_Fill(char *out, char c, unsigned char count) {
+    while (count--)
+        *out++ = c;
+    *out = 0;
+    return out;
+}
+
+
+// Copy a string
+
+char *Fmt_Str(char *out, const char *s) {
+    while (*s)
+        *out++ = *s++;
+    *out = 0;
+    return out;
+}
+
+
+// Unsigned and signed integers
+
+// sign is 0 or '-'; digits points at the first of the n digits shown
+static char *Fmt_Number(char *out, char sign, const char *digits,
+                        unsigned char n, unsigned char width, char pad) {
+    unsigned char used = n + (sign != 0);
+    if (used > width)
+        return Fmt_Fill(out, '*', width);
+
+    if (pad == ' ')
+        out = Fmt_Fill(out, ' ', width - used);
+    if (sign)
+        *out++ = sign;
+    if (pad == '0')
+        out = Fmt_Fill(out, '0', width - used);
+    while (n--)
+        *out++ = *digits++;
+    *out = 0;
+    return out;
+}
+
+char *Fmt_Uint(char *out, unsigned int v, unsigned char width) {
+    char d[5];
+    unsigned char n = Fmt_Digits(d, v);
+    return Fmt_Number(out, 0, d + 5 - n, n, width, ' ');
+}
+
+char *Fmt_Uint0(char *out, unsigned int v, unsigned char width) {
+    char d[5];
+    unsigned char n = Fmt_Digits(d, v);
+    return Fmt_Number(out, 0, d + 5 - n, n, width, '0');
+}
+
+char *Fmt_Int(char *out, int v, unsigned char width) {
+    char d[5];
+    char sign = v < 0 ? '-' : 0;
+    unsigned char n = Fmt_Digits(d, sign ? 0u - (unsigned int)v : (unsigned int)v);
+    return Fmt_Number(out, sign, d + 5 - n, n, width, ' ');
+}
+
+
+// Temperature in hundredths of a degree
+
+// 2345 -> "23.45C". width is the width of the whole-degree part,
+// including the sign.
+char *Fmt_T100(char *out, int t100, unsigned char width) {
+    char d[5];
+    char sign = t100 < 0 ? '-' : 0;
+    unsigned char n = Fmt_Digits(d, sign ? 0u - (unsigned int)t100 : (unsigned int)t100);
+
+    // The last two digits are the fraction; keep at least "0."
+    n = (n > 2) ? n - 2 : 1;
+    if (n + (sign != 0) > width)
+        return Fmt_Fill(out, '*', width + 4);
+    out = Fmt_Number(out, sign, d + 3 - n, n, width, ' ');
+    *out++ = '.';
+    *out++ = d[3];
+    *out++ = d[4];
+    *out++ = 'C';
+    *out = 0;
+    return out;
+}
+
+
+// Binary bitfield
+
+// The low 'bits' (1..8) bits of v, most significant first.
+char *Fmt_Bin(char *out, unsigned char v, unsigned char bits) {
+    unsigned char mask = (unsigned char)(1u << (bits - 1));
+    while (mask) {
+        *out++ = (v & mask) ? '1' : '0';
+        mask >>= 1;
+    }
+    *out = 0;
+    return out;
+}
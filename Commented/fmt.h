@@ -0,0 +1,21 @@
+#ifndef FMT_H
+#define FMT_H
+
+#include "hal.h"
+
+// printf-free text formatting for LCD lines
+
+// Each function writes at out, adds a terminating 0 and returns a
+// pointer to it, so calls can be chained to build a line:
+//     p = Fmt_Bin(Fmt_Str(line, "PORTB "), PORTB, 8);
+// Numbers are right-aligned in a fixed width. A value that does not
+// fit is shown as '*' characters so the rest of the line stays put.
+
+char *Fmt_Str(char *out, const char *s);
+char *Fmt_Uint(char *out, unsigned int v, unsigned char width);
+char *Fmt_Uint0(char *out, unsigned int v, unsigned char width);   // Zero-padded
+char *Fmt_Int(char *out, int v, unsigned char width);
+char *Fmt_T100(char *out, int t100, unsigned char width);        // "23.45C"
+char *Fmt_Bin(char *out, unsigned char v, unsigned char bits);   // MSB first
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef LCD_H
+#define LCD_H
+
+#include "hal.h"
+
+// Data bus width, chosen at build time
+// 0: 4-bit bus on PORTB (Commented board), two enable pulses per byte.
+// 1: 8-bit bus on PORTD (Lab7 board), one enable pulse per byte.
+#ifndef LCD_BUS_8BIT
+#define LCD_BUS_8BIT 0
+#endif
+
+#if LCD_BUS_8BIT
+// LCD wiring (8-bit mode)
+// D0..D7 = RD0..RD7, RS = RE0, EN = RE1, R/W tied to ground
+#define LCD_DATA_LAT  LATD
+#define LCD_DATA_TRIS TRISD
+#define LCD_DATA_MASK 0xFF
+#define LCD_RS LATEbits.LATE0
+#define LCD_EN LATEbits.LATE1
+#define LCD_FUNCTION_SET 0x38         // 8-bit, 2 lines, 5x8 font
+#else
+// LCD wiring (4-bit mode on PORTB)
+// D4..D7 = RB0..RB3, RS = RB4, EN = RB5, R/W = RB6
+#define LCD_DATA_LAT  LATB
+#define LCD_DATA_TRIS TRISB
+#define LCD_DATA_MASK 0x0F
+#define LCD_BUSY      PORTBbits.RB3   // D7 while reading
+#define LCD_RS LATBbits.LATB4
+#define LCD_EN LATBbits.LATB5
+#define LCD_RW LATBbits.LATB6
+#define LCD_FUNCTION_SET 0x28         // 4-bit, 2 lines, 5x8 font
+#endif
+
+// 1: poll the busy flag over R/W (fastest).
+// 0: fixed delays, for boards with R/W tied to ground.
+#ifndef LCD_USE_BUSY_FLAG
+#define LCD_USE_BUSY_FLAG (!LCD_BUS_8BIT)
+#endif
+#if LCD_USE_BUSY_FLAG && LCD_BUS_8BIT
+#error "The 8-bit wiring has R/W tied low; build with LCD_USE_BUSY_FLAG=0"
+#endif
+
+// 1: LCD_Cmd / LCD_Char / LCD_String only queue; the Timer4 interrupt
+//    (LCD_ISR_Handler) sends one queued byte or wait per interrupt.
+// 0: calls block until the LCD has executed them.
+#ifndef LCD_ASYNC
+#define LCD_ASYNC 1
+#endif
+#define LCD_QUEUE_SIZE 32             // Power of two
+
+void LCD_Bus_Write(char b);            // One enable pulse: a nibble or a byte
+#if !LCD_BUS_8BIT
+#define LCD_Nibble(nibble) LCD_Bus_Write(nibble)
+#endif
+void LCD_Cmd(char cmd);
+void LCD_Char(char dat);
+void LCD_Init(void);
+void LCD_String(const char* str);
+void LCD_Set_Cursor(unsigned char row, unsigned char col);
+void LCD_Clear(void);
+
+// Buffered output: write into the RAM shadow, then LCD_Flush()
+// sends only the cells that changed.
+void LCD_Buf_Set_Cursor(unsigned char row, unsigned char col);
+void LCD_Buf_Char(char dat);
+void LCD_Buf_String(const char* str);
+void LCD_Flush(void);
+
+extern unsigned long lcd_bus_transactions;   // enable pulses sent
+
+void LCD_Wait_Idle(void);              // Block until everything queued is shown
+
+#if LCD_ASYNC
+void LCD_ISR_Handler(void);            // Call on PIR5bits.TMR4IF
+unsigned char LCD_Pending(void);       // Entries still queued
+extern unsigned int lcd_q_overflows;   // Entries dropped because the queue was full
+extern unsigned char lcd_q_high_water; // Most entries ever queued
+#endif
+
+#endif
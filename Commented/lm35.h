@@ -0,0 +1,25 @@
+#ifndef LM35_H
+#define LM35_H
+
+#include "hal.h"
+#include "adc.h"
+
+#define LM35_CHANNEL 6        // AN6 = RE1
+#define LM35_RATE_HZ 100      // Readings per second
+
+// Oversampling: 0 = off, 1 = 4x (11 bits), 2 = 16x (12 bits),
+// 3 = 64x (13 bits). At 5 V one 10-bit step is 0.49 C; 12 bits
+// brings it to 0.12 C.
+#ifndef LM35_EXTRA_BITS
+#define LM35_EXTRA_BITS 2
+#endif
+
+// Entry for a shared adc_scan_t table: call LM35_Init() first, then
+// ADC_Scan_Start() with the table. Readings still go through the ring.
+#define LM35_SCAN_ENTRY { LM35_CHANNEL, LM35_EXTRA_BITS, LM35_RATE_HZ, ADC_Queue }
+
+void LM35_Init(void);
+unsigned int LM35_Read_Temp(void);   // Whole degrees C
+unsigned int LM35_Read_T100(void);   // Hundredths of a degree C
+
+#endif
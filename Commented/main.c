@@ -0,0 +1,155 @@
+#include "config_bits.h"
+#include "adc.h"
+#include "debounce.h"
+#include "fmt.h"
+#include "lcd.h"
+#include "lm35.h"
+#include "sched.h"
+#include "sevenseg.h"
+#include "templog.h"
+#include "tone.h"
+
+#pragma config FOSC = INTIO67   // Internal oscillator, RA6/RA7 as I/O
+#pragma config PLLCFG = OFF
+#pragma config WDTEN = OFF      // Watchdog off
+#pragma config PBADEN = OFF     // PORTB<5:0> digital on reset
+#pragma config MCLRE = EXTMCLR  // MCLR pin enabled
+#pragma config LVP = OFF
+
+
+// Interrupt service routine
+
+// Timer0 drives the seven-segment multiplexing,
+// Timer4 drains the LCD queue, the ADC queues the
+// LM35 samples that Timer3/CCP5 trigger, the
+// EEPROM interrupt starts the next queued log write,
+// CCP1 and Timer2 play the buzzer and Timer6 is
+// the scheduler's 1 ms tick.
+HAL_ISR(isr) {
+    if (INTCONbits.TMR0IF)
+        SevenSeg_ISR_Handler();
+    if (PIR1bits.ADIF)
+        ADC_ISR_Handler();
+    if (PIR2bits.EEIF)
+        TempLog_ISR_Handler();
+    if (PIR5bits.TMR6IF)
+        Sched_ISR_Handler();
+    if (PIR1bits.CCP1IF)
+        Tone_ISR_Handler();
+    if (PIR1bits.TMR2IF)
+        Tone_Tick_Handler();
+#if LCD_ASYNC
+    if (PIR5bits.TMR4IF)
+        LCD_ISR_Handler();
+#endif
+}
+
+
+// Tasks
+
+// The main loop only runs these, each to completion when its timer
+// posts it. The temperature goes to the seven-segment display every
+// 100 ms and into the EEPROM log every LOG_PERIOD_MS; the LCD's
+// second line shows either the log's range or the scheduler's own
+// figures, switched by the button on RB7 (RB0..RB6 are the LCD).
+// Above ALARM_T100 the buzzer beeps every status update.
+#define TEMP_PERIOD_MS   100
+#define STATUS_PERIOD_MS 500
+#define LOG_PERIOD_MS    60000        // Once a minute
+#define ALARM_T100       4000         // 40.00 C
+#define BTN_VIEW         0x80         // RB7
+
+static unsigned char task_buttons, task_temp, task_status, task_log;
+static unsigned char view;            // 0: log range, 1: scheduler
+static unsigned int last_t100;
+
+static void buttons_task(void) {
+    Debounce_Tick();
+    if (Debounce_Pressed(BTN_VIEW)) {
+        view ^= 1;
+        Tone_Play(NOTE(A, 5), 30);        // Click
+        Sched_Post(task_status);
+    }
+}
+
+// Whole degrees on the display, / 100 as a multiply and shift (see
+// bcd.c). The display has no minus sign: below 0 C it shows 0.
+static void temp_task(void) {
+    int t = (int)LM35_Read_T100();
+
+    last_t100 = (unsigned int)t;
+    if (t < 0)
+        t = 0;
+    SevenSeg_Update_Value((unsigned int)(((unsigned long)t * 5243u) >> 19));
+}
+
+static void log_task(void) {
+    TempLog_Add(last_t100);
+}
+
+static void status_task(void) {
+    char line[17], *p;
+    sched_stats_t st;
+    unsigned int wcet = 0, over = 0;
+    unsigned char i;
+
+    if (view == 0 && TempLog_Count() == 0) {
+        p = Fmt_Str(line, "L--.--C H--.--C ");  // Nothing logged yet
+    } else if (view == 0) {
+        p = Fmt_Str(line, "L");            // "L21.50C H24.25C "
+        p = Fmt_T100(p, (int)TempLog_Min(), 2);
+        p = Fmt_Str(p, " H");
+        p = Fmt_T100(p, (int)TempLog_Max(), 2);
+        p = Fmt_Str(p, " ");
+    } else {
+        for (i = task_buttons; i <= task_log; i++) {
+            Sched_Get_Stats(i, &st);
+            if (st.wcet_us > wcet)
+                wcet = st.wcet_us;
+            over += st.overruns;
+        }
+        p = Fmt_Str(line, "WCET");
+        p = Fmt_Uint(p, wcet, 5);
+        p = Fmt_Str(p, "us OV");
+        p = Fmt_Uint(p, over, 2);
+    }
+    LCD_Buf_Set_Cursor(2, 0);              // Below the heading
+    LCD_Buf_String(line);
+    LCD_Flush();
+
+    if (last_t100 >= ALARM_T100 && !Tone_Busy())
+        Tone_Play(NOTE(E, 6), 100);
+}
+
+
+// Main program
+
+// Everything is set up first (LCD_Init and LCD_String only queue);
+// from then on nothing waits.
+void main(void) {
+    OSCCONbits.IRCF = 7;          // 16 MHz internal oscillator
+
+    LM35_Init();
+    SevenSeg_Init();
+    LCD_Init();
+    TempLog_Init();
+    Tone_Init();
+    TRISBbits.TRISB7 = 1;         // Button, below the LCD's RB0..RB6
+    Debounce_Init_Polled(BTN_VIEW);
+    Sched_Init();
+
+    LCD_Set_Cursor(1, 0);
+    LCD_String("Temperature (C)");
+
+    task_buttons = Sched_Task(buttons_task);
+    task_temp = Sched_Task(temp_task);
+    task_status = Sched_Task(status_task);
+    task_log = Sched_Task(log_task);
+    Sched_Every(task_buttons, DEBOUNCE_TICK_MS);
+    Sched_Every(task_temp, TEMP_PERIOD_MS);
+    Sched_Every(task_status, STATUS_PERIOD_MS);
+    Sched_Every(task_log, LOG_PERIOD_MS);
+
+    INTCONbits.GIE = 1;           // Enable interrupts
+    Sched_Run();
+}
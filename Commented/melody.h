@@ -0,0 +1,35 @@
+#ifndef MELODY_H
+#define MELODY_H
+
+#include "hal.h"
+#include "tone.h"
+
+// Songs played from flash by the Timer2 tick
+
+// Each time a note ends, the tick interrupt starts the next one, so
+// Melody_Start returns at once and the main loop stays free. Songs are
+// byte arrays, normally written by tools/songgen.py from text:
+//
+//   step_ms low, step_ms high   Tempo: the length of one step
+//   gap_ms                      Silence cut from the end of each note
+//   note, steps                 ... one pair per note: a tone.h note
+//                               or TONE_REST, and its length, 1..255
+//   MELODY_END
+//
+// step_ms * steps must stay below 65536 and above gap_ms.
+
+#define MELODY_END   0xFF
+#define MELODY_QUEUE 4                 // Notes Melody_Queue can hold
+
+void Melody_Start(const unsigned char *song, unsigned char loop);
+void Melody_Stop(void);                // Song, queue and current note
+unsigned char Melody_Playing(void);    // A song or queued note is running
+
+// Plays a note after the song (after this pass when looping), or at
+// once if nothing is playing. ms 0 is taken as 1. Returns 0 if the
+// queue is full.
+unsigned char Melody_Queue(unsigned char note, unsigned int ms);
+
+void Melody_Tick_Handler(void);        // Call on PIR1bits.TMR2IF instead
+                                       // of Tone_Tick_Handler
+#endif
@@ -0,0 +1,24 @@
+#ifndef POWER_H
+#define POWER_H
+
+#include "hal.h"
+
+// Sleep between button events
+
+// The core sleeps until a button changes: INT0..INT2 on RB0..RB2 and
+// interrupt-on-change on RB4..RB7. The edge is handed to the debouncer
+// in the interrupt, so it reaches the main loop within microseconds of
+// the wake-up. While the debouncer is still settling the core idles
+// instead (CPU stopped, timers running) so its tick keeps coming.
+//
+// Timer5 counts the time spent awake, which with the wake count gives
+// the duty cycle.
+
+void Power_Init(unsigned char pins);   // PORTB pins that wake (RB3 cannot)
+void Power_ISR_Handler(void);          // Call on every interrupt; checks its own flags
+void Power_Sleep(unsigned char busy);  // busy: a clocked peripheral must keep running
+
+unsigned long Power_Wakes(void);
+unsigned long Power_Active_Us(void);   // Time awake since Power_Init
+
+#endif
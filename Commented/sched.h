@@ -0,0 +1,53 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#include "hal.h"
+
+// Cooperative scheduler on a 1 ms tick
+
+// Timer6 interrupts every millisecond. Software timers hang off a
+// wheel of SCHED_WHEEL slots picked by the low bits of the tick they
+// are due on, so a tick only walks the timers in its own slot. A
+// timer that expires posts its task; Sched_Run calls the posted tasks
+// from the main loop, lowest number first, each to completion.
+//
+// Every run is timed against Timer6 (4 us resolution) for the task's
+// worst case, and a task posted again before it has run counts an
+// overrun. Tasks must not wait: split longer work over timer posts.
+//
+// Sched_Init takes Timer6 over from Debounce_Init; once Sched_Active()
+// the ISR hands TMR6IF here, and buttons are sampled by a task calling
+// Debounce_Tick (see Debounce_Init_Polled).
+
+#define SCHED_TASKS  8
+#define SCHED_TIMERS 8
+#define SCHED_WHEEL  16                // Slots, a power of two
+#define SCHED_NONE   0xFF              // No task / no timer
+
+typedef void (*sched_task_t)(void);
+
+typedef struct {
+    unsigned int runs;
+    unsigned int wcet_us;              // Longest run, saturating
+    unsigned int overruns;             // Posts while still pending
+} sched_stats_t;
+
+void Sched_Init(void);                 // Timer6 at 1 ms, no tasks
+void Sched_ISR_Handler(void);          // Call on PIR5bits.TMR6IF
+unsigned char Sched_Active(void);      // Timer6 is the scheduler's
+unsigned int Sched_Millis(void);       // Ticks since Sched_Init, wrapping
+
+unsigned char Sched_Task(sched_task_t fn);   // Task number, or SCHED_NONE
+void Sched_Post(unsigned char task);         // Run it soon (tasks or ISRs)
+
+// Timers post 'task' after 'ms' (1..65535), then every 'ms' for
+// Sched_Every. They return the timer number, or SCHED_NONE.
+unsigned char Sched_After(unsigned char task, unsigned int ms);
+unsigned char Sched_Every(unsigned char task, unsigned int ms);
+void Sched_Cancel(unsigned char timer);
+
+unsigned char Sched_Run_Once(void);    // Runs one posted task; 0 if none
+void Sched_Run(void);                  // Runs tasks for ever
+void Sched_Get_Stats(unsigned char task, sched_stats_t *s);
+
+#endif
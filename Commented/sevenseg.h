@@ -0,0 +1,20 @@
+#ifndef SEVENSEG_H
+#define SEVENSEG_H
+
+#include "hal.h"
+
+// Segment lines a..g, dp on RD0..RD7
+// Digit enables on RA0..RA3 (RA0 = rightmost)
+
+#define SEG_SCROLL_MAX 32   // Longest text SevenSeg_Scroll_Text keeps
+
+void SevenSeg_Init(void);
+void SevenSeg_Update_Value(unsigned int number);
+void SevenSeg_ISR_Handler(void);
+
+// Text and hex (see SEG_GLYPH in SevenSeg.c for the character set)
+void SevenSeg_Show_Text(const char *text);
+void SevenSeg_Show_Hex(unsigned int value);
+void SevenSeg_Scroll_Text(const char *text, unsigned char frames_per_step);
+
+#endif
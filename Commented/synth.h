@@ -0,0 +1,41 @@
+#ifndef SYNTH_H
+#define SYNTH_H
+
+#include "hal.h"
+#include "tone.h"
+
+// Polyphonic buzzer: square-wave voices mixed into CCP1 PWM on RC2
+
+// Timer2 runs the PWM at 62.5 kHz with 256 duty steps and interrupts
+// on every 8th period, SYNTH_RATE times a second. Each interrupt adds
+// each voice's increment to its 16-bit phase, sums the amplitudes of
+// the voices in the high half of their cycle and loads that as the
+// next duty. bench-xc8 reports the time this takes as synth_isr.
+//
+// Every SYNTH_ENV_SAMPLES samples (16 ms) a decaying voice loses
+// 1/2^decay of its amplitude; a voice that reaches 0 is silent, and
+// when all are the PWM and Timer2 stop.
+//
+// Synth and Tone share CCP1 and Timer2: the interrupt goes to
+// Synth_ISR_Handler while Synth_Busy(), otherwise to Tone/Melody.
+// Stop whichever is playing before starting the other.
+
+#define SYNTH_VOICES      3
+#define SYNTH_RATE        7812         // Samples per second
+#define SYNTH_ENV_SAMPLES 128
+#define SYNTH_LEVEL_MAX   85           // Per voice: 3 x 85 = 255
+#define SYNTH_FIRST       TONE_FIRST   // 110 Hz
+#define SYNTH_LAST        NOTE(C, 7)   // 2093 Hz, well below SYNTH_RATE / 2
+
+void Synth_Init(void);                 // RC2 output, CCP1 on Timer2
+
+// Starts (or retunes) a voice. decay 0 holds the level; 1..7 fade it,
+// 3 over about 0.4 s, 4 over about 0.8 s.
+void Synth_Note(unsigned char voice, unsigned char note,
+                unsigned char level, unsigned char decay);
+void Synth_Release(unsigned char voice);   // Fade out quickly
+void Synth_Stop(void);                 // Every voice, at once
+unsigned char Synth_Busy(void);        // A voice still sounds
+void Synth_ISR_Handler(void);          // PIR1bits.TMR2IF while Synth_Busy()
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef TEMPLOG_H
+#define TEMPLOG_H
+
+#include "hal.h"
+
+// Temperature history in the data EEPROM
+
+// T100 samples are stored as deltas, one byte for a change of up to
+// about +-0.6 C, so the 256-byte EEPROM holds about 220 samples
+// instead of 128. The EEPROM is used as a ring of 16-byte blocks,
+// overwriting the oldest block once it is full. Every cell is written
+// once per lap, so wear is spread evenly. Nothing in the EEPROM is
+// rewritten in place, not even an index: the write position is
+// recovered at power-up from a lap bit stored in every byte.
+//
+// TempLog_Add never waits. EEPROM writes (4 ms each) are queued and
+// started one after another from the EEPROM write interrupt.
+
+#define TLOG_BLOCK 16                 // Bytes per block (keyframe + deltas)
+#define TLOG_BLOCKS 16                // 256 bytes in all
+#define TLOG_QUEUE_SIZE 16            // Pending EEPROM writes, power of two
+
+void TempLog_Init(void);               // Find the write position, rebuild stats
+void TempLog_Add(unsigned int t100);   // 0..9999; queues 1-4 EEPROM writes
+void TempLog_ISR_Handler(void);        // Call on PIR2bits.EEIF
+unsigned char TempLog_Pending(void);   // EEPROM writes not yet finished
+
+// Statistics over the history found at power-up plus every sample
+// added since, updated in constant time per sample
+unsigned long TempLog_Count(void);
+unsigned int TempLog_Min(void);
+unsigned int TempLog_Max(void);
+unsigned int TempLog_Mean(void);
+
+// Readout, oldest first. TempLog_Rewind waits for the queued writes
+// (interrupts must be on) and every read waits for a write in
+// progress, so call these from a command handler, not the display loop.
+void TempLog_Rewind(void);
+unsigned char TempLog_Next(unsigned int *t100);  // 1 = sample, 0 = end
+
+extern unsigned int tlog_dropped;      // Samples lost because the queue was full
+
+#endif
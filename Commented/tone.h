@@ -0,0 +1,40 @@
+#ifndef TONE_H
+#define TONE_H
+
+#include "hal.h"
+
+// Buzzer tones on RC2
+
+// CCP1 toggles RC2 in hardware each time Timer1 reaches CCPR1; the
+// interrupt only moves CCPR1 on by the half period, which comes from
+// a precomputed table, so the pitch is exact to 250 ns and does not
+// depend on interrupt latency. Timer2 ticks every millisecond while a
+// note plays and ends it after its duration. Tone_Play returns at once.
+
+// Notes are MIDI numbers: NOTE(A, 4) = 69 = 440 Hz, equal temperament
+#define NOTE_C  0
+#define NOTE_CS 1
+#define NOTE_D  2
+#define NOTE_DS 3
+#define NOTE_E  4
+#define NOTE_F  5
+#define NOTE_FS 6
+#define NOTE_G  7
+#define NOTE_GS 8
+#define NOTE_A  9
+#define NOTE_AS 10
+#define NOTE_B  11
+#define NOTE(n, octave) ((unsigned char)(((octave) + 1) * 12 + NOTE_##n))
+
+#define TONE_FIRST NOTE(A, 2)          // 110 Hz
+#define TONE_LAST  NOTE(C, 8)          // 4186 Hz
+#define TONE_REST  0                   // Silence for the duration
+
+void Tone_Init(void);                  // RC2 output, Timer1 and Timer2
+void Tone_Play(unsigned char note, unsigned int ms);   // ms = 0: until Tone_Stop
+void Tone_Stop(void);
+unsigned char Tone_Busy(void);         // A note or rest is still running
+void Tone_ISR_Handler(void);           // Call on PIR1bits.CCP1IF
+void Tone_Tick_Handler(void);          // Call on PIR1bits.TMR2IF
+
+#endif
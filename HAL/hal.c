@@ -0,0 +1,19 @@
+// hal.c
+// Target-side helpers for hal.h.  Not used by the host simulator build.
+
+#ifndef HOST_SIM
+
+#define _XTAL_FREQ 16000000UL
+#include "hal.h"
+
+// __delay_ms/__delay_us need compile-time constants, so run-time delays
+// are built from 1 ms / 1 us steps.  Loop overhead makes Delay_us run long.
+void Delay_ms(unsigned int ms) {
+    while (ms--) __delay_ms(1);
+}
+
+void Delay_us(unsigned int us) {
+    while (us--) __delay_us(1);
+}
+
+#endif
@@ -0,0 +1,81 @@
+// hal.h
+// Hardware abstraction for the PIC18(L)F4XK22 labs.
+//
+// On the board this is just <xc.h>.  Building with -DHOST_SIM swaps in the
+// register simulator in sim/pic18_sim.h so the same sources run on Linux,
+// with delays advancing a virtual cycle clock.
+
+#ifndef HAL_H
+#define HAL_H
+
+#ifdef HOST_SIM
+#include "pic18_sim.h"
+#else
+#include <xc.h>
+#endif
+
+// ------------------------------------------------------------
+// Interrupt service routine
+// ------------------------------------------------------------
+// HAL_ISR(isr) { ... } declares the high-priority vector on XC8 and
+// registers the handler with the simulator on the host.
+#ifdef HOST_SIM
+#define HAL_ISR(name) \
+    void name(void); \
+    static void __attribute__((constructor)) name##_sim_register(void) { sim_set_isr(name); } \
+    void name(void)
+#else
+#define HAL_ISR(name) void __interrupt() name(void)
+#endif
+
+// ------------------------------------------------------------
+// Board wiring the simulator needs to know about
+// ------------------------------------------------------------
+// HAL_SIM_LCD(data_port, data_shift, ctrl_port, rs_bit, en_bit, rw_bit, bus8)
+// attaches the HD44780 model to the pins a driver uses (rw_bit -1 when
+// R/W is tied low).  It expands to nothing on the target.
+#ifdef HOST_SIM
+#define HAL_SIM_LCD(dp, ds, cp, rs, en, rw, b8) \
+    static void __attribute__((constructor)) hal_sim_lcd_attach(void) { \
+        static const sim_lcd_wiring_t w = { SIM_##dp, ds, SIM_##cp, rs, en, rw, b8 }; \
+        sim_lcd_attach(&w); \
+    }
+#else
+#define HAL_SIM_LCD(dp, ds, cp, rs, en, rw, b8)
+#endif
+
+// ------------------------------------------------------------
+// mikroC-style names used by the Lab5/Lab6/Lab7 sources
+// ------------------------------------------------------------
+#define TRISA0_bit  TRISAbits.TRISA0
+#define TRISA1_bit  TRISAbits.TRISA1
+#define TRISA2_bit  TRISAbits.TRISA2
+#define TRISA3_bit  TRISAbits.TRISA3
+#define TRISB0_bit  TRISBbits.TRISB0
+#define TRISC2_bit  TRISCbits.TRISC2
+#define TRISE1_bit  TRISEbits.TRISE1
+#define ANSELB0_bit ANSELBbits.ANSB0
+#define ANSELC2_bit ANSELCbits.ANSC2
+#define LATC2_bit   LATCbits.LATC2
+#define RB0_bit     PORTBbits.RB0
+#define RB1_bit     PORTBbits.RB1
+
+// Run-time delays (the argument need not be a constant)
+#ifdef HOST_SIM
+#define Delay_ms(x) sim_delay_cycles((unsigned long)(x) * 1000UL * SIM_TCY_PER_US)
+#define Delay_us(x) sim_delay_cycles((unsigned long)(x) * SIM_TCY_PER_US)
+#else
+void Delay_ms(unsigned int ms);
+void Delay_us(unsigned int us);
+#endif
+
+// One pass of a foreground idle loop that only polls RAM flags set by
+// interrupts.  Nothing on the target; on the host it lets the virtual
+// clock (which otherwise only moves on SFR accesses) run on.
+#ifdef HOST_SIM
+#define HAL_IDLE() sim_delay_cycles(1)
+#else
+#define HAL_IDLE()
+#endif
+
+#endif // HAL_H
@@ -0,0 +1,209 @@
+// hd44780_sim.c
+// HD44780 character LCD model for the host simulator.
+//
+// Latches RS and the data lines on each falling edge of EN, tracks the
+// 4-bit/8-bit interface state, DDRAM and the address counter, and keeps
+// the controller busy for the datasheet execution time of each
+// instruction so drivers that write too early are caught.  With R/W
+// wired, a read strobe drives the busy flag and address counter back
+// onto the data lines.
+
+#include "pic18_sim.h"
+
+#include <string.h>
+
+#define LCD_EXEC_US      37u     // most instructions
+#define LCD_WRITE_US     41u     // data write incl. address update
+#define LCD_CLEAR_US     1520u   // clear display / return home
+
+static struct {
+    int attached;
+    sim_lcd_wiring_t w;
+
+    int bus8;                   // controller interface mode
+    int have_high;              // 4-bit mode: first nibble latched
+    unsigned char high;
+    unsigned char en_prev;
+
+    int read_low;               // 4-bit read: next strobe returns low nibble
+    unsigned char drive_mask;   // data lines driven by the LCD during a read
+    unsigned char drive_level;
+
+    unsigned char ddram[0x80];
+    unsigned char ac;
+    signed char step;           // +1 / -1 from entry mode
+
+    uint64_t busy_until;
+    sim_lcd_stats_t st;
+} lcd;
+
+void sim_lcd_attach(const sim_lcd_wiring_t *w) {
+    lcd.w = *w;
+    lcd.attached = 1;
+    hd44780_reset();
+}
+
+int hd44780_attached(void) {
+    return lcd.attached;
+}
+
+void hd44780_reset(void) {
+    lcd.bus8 = 1;               // power-on state is 8-bit
+    lcd.have_high = 0;
+    lcd.en_prev = 0;
+    lcd.read_low = 0;
+    lcd.drive_mask = 0;
+    memset(lcd.ddram, ' ', sizeof lcd.ddram);
+    lcd.ac = 0;
+    lcd.step = 1;
+    lcd.busy_until = 0;
+    memset(&lcd.st, 0, sizeof lcd.st);
+}
+
+static void set_busy(unsigned int us) {
+    lcd.busy_until = sim_cycles() + (uint64_t)us * SIM_TCY_PER_US;
+}
+
+// DDRAM in two-line mode is 0x00..0x27 and 0x40..0x67
+static void ac_step(void) {
+    unsigned char a = (unsigned char)(lcd.ac + lcd.step);
+    if (lcd.step > 0) {
+        if (a == 0x28) a = 0x40;
+        else if (a == 0x68) a = 0x00;
+    } else {
+        if (a == 0x3F) a = 0x27;
+        else if (a == 0xFF) a = 0x67;
+    }
+    lcd.ac = a & 0x7F;
+}
+
+static void execute(int rs, unsigned char b) {
+    if (sim_cycles() < lcd.busy_until)
+        lcd.st.violations++;
+
+    if (rs) {
+        lcd.ddram[lcd.ac] = b;
+        ac_step();
+        lcd.st.chars++;
+        set_busy(LCD_WRITE_US);
+        return;
+    }
+
+    lcd.st.commands++;
+    if (b & 0x80) {                         // set DDRAM address
+        lcd.ac = b & 0x7F;
+    } else if (b & 0x40) {                  // set CGRAM address (not modelled)
+    } else if (b & 0x20) {                  // function set
+        lcd.bus8 = (b >> 4) & 1;
+        lcd.have_high = 0;
+        lcd.read_low = 0;
+    } else if (b & 0x18) {                  // cursor shift / display control
+    } else if (b & 0x04) {                  // entry mode
+        lcd.step = (b & 0x02) ? 1 : -1;
+    } else if (b & 0x02) {                  // return home
+        lcd.ac = 0;
+        set_busy(LCD_CLEAR_US);
+        return;
+    } else if (b == 0x01) {                 // clear display
+        memset(lcd.ddram, ' ', sizeof lcd.ddram);
+        lcd.ac = 0;
+        lcd.step = 1;
+        set_busy(LCD_CLEAR_US);
+        return;
+    }
+    set_busy(LCD_EXEC_US);
+}
+
+unsigned char hd44780_drive(unsigned char port, unsigned char *level) {
+    if (!lcd.attached || port != lcd.w.data_port)
+        return 0;
+    *level = lcd.drive_level;
+    return lcd.drive_mask;
+}
+
+// EN rose with R/W high: put BF|AC (RS=0) on the bus.  Data reads
+// (RS=1) are not modelled and return zero.
+static void read_strobe(int rs) {
+    unsigned char v = 0;
+    if (!rs)
+        v = (unsigned char)((sim_cycles() < lcd.busy_until ? 0x80 : 0x00) | lcd.ac);
+
+    if (lcd.w.bus8 && lcd.bus8) {
+        lcd.drive_mask = (unsigned char)(0xFFu << lcd.w.data_shift);
+        lcd.drive_level = (unsigned char)(v << lcd.w.data_shift);
+        return;
+    }
+    unsigned char nib = lcd.read_low ? (v & 0x0F) : (v >> 4);
+    unsigned char shift = lcd.w.bus8 ? lcd.w.data_shift + 4 : lcd.w.data_shift;
+    lcd.drive_mask = (unsigned char)(0x0Fu << shift);
+    lcd.drive_level = (unsigned char)(nib << shift);
+}
+
+void hd44780_sync(const unsigned char lat[SIM_NPORTS]) {
+    if (!lcd.attached)
+        return;
+
+    unsigned char ctrl = lat[lcd.w.ctrl_port];
+    unsigned char en = (ctrl >> lcd.w.en_bit) & 1;
+    int rs = (ctrl >> lcd.w.rs_bit) & 1;
+    int rw = lcd.w.rw_bit >= 0 && ((ctrl >> lcd.w.rw_bit) & 1);
+    unsigned char rising = !lcd.en_prev && en;
+    unsigned char falling = lcd.en_prev && !en;
+    lcd.en_prev = en;
+
+    if (rising && rw)
+        read_strobe(rs);
+    if (!falling)
+        return;
+
+    if (lcd.drive_mask) {                    // end of a read strobe
+        lcd.st.reads++;
+        lcd.drive_mask = 0;
+        if (!lcd.bus8)
+            lcd.read_low = !lcd.read_low;
+        return;
+    }
+    lcd.st.pulses++;
+    unsigned char data = lat[lcd.w.data_port];
+
+    if (lcd.w.bus8) {
+        data = (unsigned char)(data >> lcd.w.data_shift);
+        if (lcd.bus8) {
+            execute(rs, data);
+        } else if (!lcd.have_high) {
+            lcd.high = data >> 4;
+            lcd.have_high = 1;
+        } else {
+            lcd.have_high = 0;
+            execute(rs, (unsigned char)((lcd.high << 4) | (data >> 4)));
+        }
+        return;
+    }
+
+    unsigned char nib = (data >> lcd.w.data_shift) & 0x0F;
+    if (lcd.bus8) {                          // D0..D3 not wired: read as 0
+        execute(rs, (unsigned char)(nib << 4));
+    } else if (!lcd.have_high) {
+        lcd.high = nib;
+        lcd.have_high = 1;
+    } else {
+        lcd.have_high = 0;
+        execute(rs, (unsigned char)((lcd.high << 4) | nib));
+    }
+}
+
+void sim_lcd_line(unsigned char line, char out[17]) {
+    memcpy(out, &lcd.ddram[line ? 0x40 : 0x00], 16);
+    for (int i = 0; i < 16; i++)
+        if ((unsigned char)out[i] < 0x20 || (unsigned char)out[i] > 0x7E)
+            out[i] = '?';
+    out[16] = 0;
+}
+
+void sim_lcd_get_stats(sim_lcd_stats_t *s) {
+    *s = lcd.st;
+}
+
+void sim_lcd_clear_stats(void) {
+    memset(&lcd.st, 0, sizeof lcd.st);
+}
@@ -0,0 +1,923 @@
+// pic18_sim.c
+// Core of the host simulator: register storage, virtual cycle clock,
+// ports, INT0-2 and PORTB change interrupts, Timer0, Timer1/3/5,
+// Timer2/4/6, CCP1 compare, CCP5 special event, ADC, data EEPROM,
+// interrupt dispatch, Sleep/Idle and the RC2 buzzer probe (edges, or
+// the PWM duty as a level).
+
+#include "pic18_sim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ------------------------------------------------------------
+// Register storage (power-on reset values)
+// ------------------------------------------------------------
+#define SIM_PORT_STORAGE(x, ansel) \
+    volatile PORT##x##bits_t sim_PORT##x; \
+    volatile LAT##x##bits_t sim_LAT##x; \
+    volatile TRIS##x##bits_t sim_TRIS##x = { .byte = 0xFF }; \
+    volatile ANSEL##x##bits_t sim_ANSEL##x = { .byte = ansel };
+
+SIM_PORT_STORAGE(A, 0x2F)
+SIM_PORT_STORAGE(B, 0x3F)
+SIM_PORT_STORAGE(C, 0xFC)
+SIM_PORT_STORAGE(D, 0xFF)
+SIM_PORT_STORAGE(E, 0x07)
+
+volatile ADCON0bits_t sim_ADCON0;
+volatile ADCON1bits_t sim_ADCON1;
+volatile ADCON2bits_t sim_ADCON2;
+volatile SIMREG8bits_t sim_ADRESH, sim_ADRESL;
+volatile T0CONbits_t sim_T0CON = { .byte = 0xFF };
+volatile SIMREG8bits_t sim_TMR0H, sim_TMR0L;
+volatile INTCONbits_t sim_INTCON;
+volatile INTCON2bits_t sim_INTCON2 = { .byte = 0xF5 };
+volatile INTCON3bits_t sim_INTCON3 = { .byte = 0xC0 };
+volatile IOCBbits_t sim_IOCB = { .byte = 0xF0 };
+volatile PIR1bits_t sim_PIR1;
+volatile PIE1bits_t sim_PIE1;
+volatile PIR2bits_t sim_PIR2;
+volatile PIE2bits_t sim_PIE2;
+volatile PIR4bits_t sim_PIR4;
+volatile PIE4bits_t sim_PIE4;
+volatile PIR5bits_t sim_PIR5;
+volatile PIE5bits_t sim_PIE5;
+volatile T2CONbits_t sim_T2CON;
+volatile T4CONbits_t sim_T4CON;
+volatile T6CONbits_t sim_T6CON;
+volatile SIMREG8bits_t sim_TMR2, sim_TMR4, sim_TMR6;
+volatile SIMREG8bits_t sim_PR2 = { .byte = 0xFF };
+volatile SIMREG8bits_t sim_PR4 = { .byte = 0xFF };
+volatile SIMREG8bits_t sim_PR6 = { .byte = 0xFF };
+volatile T1CONbits_t sim_T1CON;
+volatile T3CONbits_t sim_T3CON;
+volatile T5CONbits_t sim_T5CON;
+volatile SIMREG8bits_t sim_TMR1H, sim_TMR1L, sim_TMR3H, sim_TMR3L, sim_TMR5H, sim_TMR5L;
+volatile CCP1CONbits_t sim_CCP1CON;
+volatile SIMREG8bits_t sim_CCPR1H, sim_CCPR1L;
+volatile CCPTMRS0bits_t sim_CCPTMRS0;
+volatile CCP5CONbits_t sim_CCP5CON;
+volatile SIMREG8bits_t sim_CCPR5H, sim_CCPR5L;
+volatile CCPTMRS1bits_t sim_CCPTMRS1;
+volatile EECON1bits_t sim_EECON1;
+volatile SIMREG8bits_t sim_EECON2, sim_EEADR, sim_EEDATA;
+volatile OSCCONbits_t sim_OSCCON = { .byte = 0x30 };
+volatile SIMREG8bits_t sim_CM1CON0, sim_CM2CON0;
+
+static volatile unsigned char *const port_reg[SIM_NPORTS] = {
+    &sim_PORTA.byte, &sim_PORTB.byte, &sim_PORTC.byte, &sim_PORTD.byte, &sim_PORTE.byte
+};
+static volatile unsigned char *const lat_reg[SIM_NPORTS] = {
+    &sim_LATA.byte, &sim_LATB.byte, &sim_LATC.byte, &sim_LATD.byte, &sim_LATE.byte
+};
+static volatile unsigned char *const tris_reg[SIM_NPORTS] = {
+    &sim_TRISA.byte, &sim_TRISB.byte, &sim_TRISC.byte, &sim_TRISD.byte, &sim_TRISE.byte
+};
+
+// ------------------------------------------------------------
+// Simulator state
+// ------------------------------------------------------------
+#define SIM_STIM_MAX 128            // pin changes scheduled ahead
+
+static struct {
+    int started;
+    uint64_t cycles;
+    uint64_t limit;             // 0 = no limit
+
+    void (*isr)(void);
+    int in_isr;
+
+    unsigned char pin_in[SIM_NPORTS];   // externally driven input levels
+    struct {
+        uint64_t at;                // cycle to apply it, 0 = free slot
+        unsigned char port, bit, level;
+    } stim[SIM_STIM_MAX];
+    int asleep;                     // in SLEEP until an interrupt flag is raised
+    int clock_off;                  // Sleep rather than Idle: peripherals stopped
+    unsigned char port_seen[SIM_NPORTS];
+    unsigned char lat_seen[SIM_NPORTS];
+
+    unsigned int tmr0;
+    unsigned int t0_acc;
+    unsigned char t0_seen_h, t0_seen_l;
+
+    struct {
+        unsigned int acc;           // Tcy not yet turned into a count
+        unsigned char post;         // postscaler count
+        unsigned char seen;         // TMRx as last written back
+    } t8[3];
+
+    struct {
+        unsigned int tmr;
+        unsigned int acc;
+        unsigned char seen_h, seen_l;
+    } t16[3];
+
+    int adc_busy;
+    uint64_t adc_done_at;
+    unsigned long adc_uv[32];
+    unsigned long adc_noise_uv;     // peak of the uniform input noise
+    uint32_t adc_seed;
+    unsigned int vdd_mv;
+
+    unsigned char ee[SIM_EEPROM_SIZE];
+    unsigned char ee_unlock;        // 0x55 then 0xAA seen in EECON2
+    int ee_busy;
+    uint64_t ee_done_at;
+    unsigned char ee_addr, ee_data; // latched when WR was set
+    unsigned long ee_writes;
+
+    unsigned char ccp1_out;         // CCP1 compare output latch
+    unsigned char ccp1_seen;        // CCP1CON as last seen
+
+    unsigned long buz_edges;
+    uint64_t buz_last_rise;
+    uint64_t buz_period;
+} sim;
+
+static void sim_start(void);
+
+// Supply, and so ADC reference, of the board being built for
+#ifdef VREF_mV
+#define SIM_VDD_MV VREF_mV
+#else
+#define SIM_VDD_MV 5000u
+#endif
+
+// ------------------------------------------------------------
+// Ports
+// ------------------------------------------------------------
+
+// A write to PORTx lands in LATx, exactly like the silicon.  PORTx then
+// reads back LAT for outputs and the external level for inputs.
+// CCP1 compare modes that drive RC2 (toggle, set, clear on match)
+static int ccp1_drives_rc2(void) {
+    unsigned char m = sim_CCP1CON.bits.CCP1M;
+    return m == 0x02 || m == 0x08 || m == 0x09;
+}
+
+// Input edges on PORTB: RB0..RB2 raise INT0IF..INT2IF on the edge
+// picked by INTEDGx, any change on an RB4..RB7 enabled in IOCB
+// raises RBIF.
+static void portb_edges(unsigned char was, unsigned char now) {
+    unsigned char in = sim_TRISB.byte;
+    unsigned char rise = (unsigned char)(~was & now & in);
+    unsigned char fall = (unsigned char)(was & ~now & in);
+    unsigned char edg = sim_INTCON2.byte;
+    if ((edg & 0x40) ? (rise & 0x01) : (fall & 0x01)) sim_INTCON.bits.INT0IF = 1;
+    if ((edg & 0x20) ? (rise & 0x02) : (fall & 0x02)) sim_INTCON3.bits.INT1IF = 1;
+    if ((edg & 0x10) ? (rise & 0x04) : (fall & 0x04)) sim_INTCON3.bits.INT2IF = 1;
+    if ((rise | fall) & sim_IOCB.byte & 0xF0) sim_INTCON.bits.RBIF = 1;
+}
+
+static void ports_sync(void) {
+    for (int p = 0; p < SIM_NPORTS; p++) {
+        if (*port_reg[p] != sim.port_seen[p])
+            *lat_reg[p] = *port_reg[p];
+        unsigned char tris = *tris_reg[p];
+        unsigned char level = 0;
+        unsigned char driven = hd44780_drive((unsigned char)p, &level);
+        unsigned char in = (unsigned char)((sim.pin_in[p] & ~driven) | (level & driven));
+        *port_reg[p] = (unsigned char)((*lat_reg[p] & ~tris) | (in & tris));
+        if (p == SIM_PORTC && ccp1_drives_rc2() && !(tris & 0x04))
+            *port_reg[p] = (unsigned char)((*port_reg[p] & ~0x04) | (sim.ccp1_out << 2));
+        if (p == SIM_PORTB && *port_reg[p] != sim.port_seen[p])
+            portb_edges(sim.port_seen[p], *port_reg[p]);
+        sim.port_seen[p] = *port_reg[p];
+    }
+}
+
+static void buzzer_edge(int high) {
+    sim.buz_edges++;
+    if (high) {
+        if (sim.buz_last_rise)
+            sim.buz_period = sim.cycles - sim.buz_last_rise;
+        sim.buz_last_rise = sim.cycles;
+    }
+}
+
+static void buzzer_sync(void) {
+    unsigned char now = sim_LATC.byte & 0x04;
+    if (now != (sim.lat_seen[SIM_PORTC] & 0x04) && !ccp1_drives_rc2())
+        buzzer_edge(now != 0);
+}
+
+static void outputs_sync(void) {
+    unsigned char lat[SIM_NPORTS];
+    for (int p = 0; p < SIM_NPORTS; p++)
+        lat[p] = *lat_reg[p];
+    buzzer_sync();
+    hd44780_sync(lat);
+    memcpy(sim.lat_seen, lat, sizeof lat);
+}
+
+// ------------------------------------------------------------
+// Timer0
+// ------------------------------------------------------------
+static unsigned int t0_prescale(void) {
+    return sim_T0CON.bits.PSA ? 1u : (2u << sim_T0CON.bits.T0PS);
+}
+
+static unsigned int t0_top(void) {
+    return sim_T0CON.bits.T08BIT ? 0xFFu : 0xFFFFu;
+}
+
+// Software wrote TMR0L (and the buffered TMR0H) since we last looked
+static void t0_sync(void) {
+    if (sim_TMR0L.byte != sim.t0_seen_l || sim_TMR0H.byte != sim.t0_seen_h) {
+        sim.tmr0 = sim_T0CON.bits.T08BIT ? sim_TMR0L.byte
+                 : ((unsigned int)sim_TMR0H.byte << 8) | sim_TMR0L.byte;
+        sim.t0_acc = 0; // a write clears the prescaler
+    }
+}
+
+static uint64_t t0_cycles_to_overflow(void) {
+    if (!sim_T0CON.bits.TMR0ON || sim_T0CON.bits.T0CS)
+        return UINT64_MAX;
+    uint64_t counts = (uint64_t)(t0_top() - sim.tmr0) + 1u;
+    return counts * t0_prescale() - sim.t0_acc;
+}
+
+static void t0_run(uint64_t n) {
+    if (!sim_T0CON.bits.TMR0ON || sim_T0CON.bits.T0CS)
+        return;
+    unsigned int ps = t0_prescale();
+    uint64_t acc = sim.t0_acc + n;
+    uint64_t ticks = acc / ps;
+    sim.t0_acc = (unsigned int)(acc % ps);
+
+    uint64_t period = (uint64_t)t0_top() + 1u;
+    uint64_t v = sim.tmr0 + ticks;
+    if (v >= period) {
+        sim_INTCON.bits.TMR0IF = 1;
+        v %= period;
+    }
+    sim.tmr0 = (unsigned int)v;
+    sim_TMR0L.byte = (unsigned char)v;
+    sim_TMR0H.byte = (unsigned char)(v >> 8);
+    sim.t0_seen_l = sim_TMR0L.byte;
+    sim.t0_seen_h = sim_TMR0H.byte;
+}
+
+// ------------------------------------------------------------
+// Timer2 / Timer4 / Timer6
+// ------------------------------------------------------------
+// TMRx counts prescaled Tcy up to PRx, then resets; every OUTPS+1
+// matches the interrupt flag is set. Writing TMRx clears the prescaler
+// and postscaler counts.
+static volatile unsigned char *const t8_con[3] = { &sim_T2CON.byte, &sim_T4CON.byte, &sim_T6CON.byte };
+static volatile unsigned char *const t8_tmr[3] = { &sim_TMR2.byte, &sim_TMR4.byte, &sim_TMR6.byte };
+static volatile unsigned char *const t8_pr[3] = { &sim_PR2.byte, &sim_PR4.byte, &sim_PR6.byte };
+
+static unsigned int t8_prescale(unsigned char con) {
+    static const unsigned char ps[4] = { 1, 4, 16, 16 };
+    return ps[con & 0x03];
+}
+
+static void t8_flag(int i) {
+    if (i == 0) sim_PIR1.bits.TMR2IF = 1;
+    else if (i == 1) sim_PIR5.bits.TMR4IF = 1;
+    else sim_PIR5.bits.TMR6IF = 1;
+}
+
+static void t8_sync(void) {
+    for (int i = 0; i < 3; i++) {
+        if (*t8_tmr[i] != sim.t8[i].seen) { // software wrote TMRx
+            sim.t8[i].acc = 0;
+            sim.t8[i].post = 0;
+        }
+    }
+}
+
+static uint64_t t8_cycles_to_match(void) {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 3; i++) {
+        unsigned char con = *t8_con[i];
+        if (!(con & 0x04))
+            continue;
+        unsigned int counts = (unsigned int)(*t8_pr[i] - *t8_tmr[i]) + 1u;
+        if (*t8_tmr[i] > *t8_pr[i]) counts = 256u - *t8_tmr[i] + *t8_pr[i] + 1u;
+        uint64_t c = (uint64_t)counts * t8_prescale(con) - sim.t8[i].acc;
+        if (c < best) best = c;
+    }
+    return best;
+}
+
+static void t8_run(uint64_t n) {
+    for (int i = 0; i < 3; i++) {
+        unsigned char con = *t8_con[i];
+        if (!(con & 0x04))
+            continue;
+        unsigned int ps = t8_prescale(con);
+        uint64_t acc = sim.t8[i].acc + n;
+        uint64_t ticks = acc / ps;
+        sim.t8[i].acc = (unsigned int)(acc % ps);
+        unsigned char tmr = *t8_tmr[i];
+        while (ticks--) {
+            if (tmr == *t8_pr[i]) {
+                tmr = 0;
+                if (++sim.t8[i].post > ((con >> 3) & 0x0F)) {
+                    sim.t8[i].post = 0;
+                    t8_flag(i);
+                }
+            } else {
+                tmr++;
+            }
+        }
+        *t8_tmr[i] = tmr;
+        sim.t8[i].seen = tmr;
+    }
+}
+
+// ------------------------------------------------------------
+// Timer1 / Timer3 / Timer5 and the CCP5 special event trigger
+// ------------------------------------------------------------
+// 16-bit timers clocked from Fosc/4 (TMRxCS = 0) or Fosc (TMRxCS = 1).
+// When CCP5 is in special event mode (CCP5M = 1011) on the timer picked
+// by C5TSEL, TMRx == CCPR5 makes the next count reset the timer, set
+// CCP5IF and start an ADC conversion, so the period is CCPR5 + 1 counts.
+// CCP1 in a compare mode (CCP1M = 0010 or 10xx) on the timer picked by
+// C1TSEL sets CCP1IF when TMRx reaches CCPR1, toggling, setting or
+// clearing its output on RC2; the timer keeps counting.
+static volatile unsigned char *const t16_con[3] = { &sim_T1CON.byte, &sim_T3CON.byte, &sim_T5CON.byte };
+static volatile unsigned char *const t16_h[3] = { &sim_TMR1H.byte, &sim_TMR3H.byte, &sim_TMR5H.byte };
+static volatile unsigned char *const t16_l[3] = { &sim_TMR1L.byte, &sim_TMR3L.byte, &sim_TMR5L.byte };
+
+static int t16_running(int i) {
+    unsigned char con = *t16_con[i];
+    return (con & 0x01) && (con >> 6) < 2;
+}
+
+// Input clocks per count; TMRxCS = 1 counts Fosc, four clocks per Tcy
+static unsigned int t16_prescale(int i, unsigned int *per_tcy) {
+    unsigned char con = *t16_con[i];
+    *per_tcy = (con >> 6) == 1 ? 4u : 1u;
+    return 1u << ((con >> 4) & 0x03);
+}
+
+static int t16_special_event(int i) {
+    return sim_CCP5CON.bits.CCP5M == 0x0B && sim_CCPTMRS1.bits.C5TSEL == i;
+}
+
+static unsigned int ccpr5(void) {
+    return ((unsigned int)sim_CCPR5H.byte << 8) | sim_CCPR5L.byte;
+}
+
+static int t16_compare1(int i) {
+    unsigned char m = sim_CCP1CON.bits.CCP1M;
+    return (m == 0x02 || (m >= 0x08 && m <= 0x0A)) && sim_CCPTMRS0.bits.C1TSEL == i;
+}
+
+static unsigned int ccpr1(void) {
+    return ((unsigned int)sim_CCPR1H.byte << 8) | sim_CCPR1L.byte;
+}
+
+static void ccp1_match(void) {
+    unsigned char m = sim_CCP1CON.bits.CCP1M;
+    unsigned char out = m == 0x02 ? !sim.ccp1_out : m == 0x08 ? 1 : m == 0x09 ? 0 : sim.ccp1_out;
+    sim_PIR1.bits.CCP1IF = 1;
+    if (out != sim.ccp1_out) {
+        sim.ccp1_out = out;
+        if (!sim_TRISC.bits.TRISC2)
+            buzzer_edge(out);
+    }
+}
+
+static void t16_flag(int i) {
+    if (i == 0) sim_PIR1.bits.TMR1IF = 1;
+    else if (i == 1) sim_PIR2.bits.TMR3IF = 1;
+    else sim_PIR5.bits.TMR5IF = 1;
+}
+
+static void t16_sync(void) {
+    if (sim_CCP1CON.byte != sim.ccp1_seen) {
+        if (!ccp1_drives_rc2())
+            sim.ccp1_out = 0;       // output latch back to its default low
+        sim.ccp1_seen = sim_CCP1CON.byte;
+    }
+    for (int i = 0; i < 3; i++) {
+        if (*t16_l[i] != sim.t16[i].seen_l || *t16_h[i] != sim.t16[i].seen_h) {
+            sim.t16[i].tmr = ((unsigned int)*t16_h[i] << 8) | *t16_l[i];
+            sim.t16[i].acc = 0;     // a write clears the prescaler
+        }
+    }
+}
+
+// Timer counts until the next flag (overflow or special event)
+static unsigned long t16_counts_to_event(int i) {
+    unsigned int tmr = sim.t16[i].tmr;
+    if (t16_special_event(i) && tmr <= ccpr5())
+        return (unsigned long)(ccpr5() - tmr) + 1u;
+    return 0x10000ul - tmr;
+}
+
+// Timer counts until TMRx next equals CCPR1 (a full turn if it does now)
+static unsigned long t16_counts_to_compare(int i) {
+    if (!t16_compare1(i))
+        return 0x20000ul;
+    unsigned int d = (unsigned int)(ccpr1() - sim.t16[i].tmr) & 0xFFFFu;
+    return d ? d : 0x10000ul;
+}
+
+static uint64_t t16_cycles_to_event(void) {
+    uint64_t best = UINT64_MAX;
+    for (int i = 0; i < 3; i++) {
+        if (!t16_running(i))
+            continue;
+        unsigned int per_tcy;
+        unsigned int ps = t16_prescale(i, &per_tcy);
+        unsigned long counts = t16_counts_to_event(i);
+        if (t16_counts_to_compare(i) < counts)
+            counts = t16_counts_to_compare(i);
+        uint64_t clocks = (uint64_t)counts * ps - sim.t16[i].acc;
+        uint64_t c = (clocks + per_tcy - 1u) / per_tcy;
+        if (c < best) best = c;
+    }
+    return best;
+}
+
+static void t16_run(uint64_t n) {
+    for (int i = 0; i < 3; i++) {
+        if (!t16_running(i))
+            continue;
+        unsigned int per_tcy;
+        unsigned int ps = t16_prescale(i, &per_tcy);
+        uint64_t acc = sim.t16[i].acc + n * per_tcy;
+        uint64_t ticks = acc / ps;
+        sim.t16[i].acc = (unsigned int)(acc % ps);
+        while (ticks) {
+            unsigned long to_event = t16_counts_to_event(i);
+            unsigned long to_cmp = t16_counts_to_compare(i);
+            if (ticks < to_event && ticks < to_cmp) {
+                sim.t16[i].tmr += (unsigned int)ticks;
+                break;
+            }
+            if (to_cmp < to_event) {
+                ticks -= to_cmp;
+                sim.t16[i].tmr += (unsigned int)to_cmp;
+                ccp1_match();
+                continue;
+            }
+            ticks -= to_event;
+            if (to_cmp == to_event && ccpr1() == 0)
+                ccp1_match();       // reaches 0000 as it overflows
+            if (t16_special_event(i) && sim.t16[i].tmr <= ccpr5()) {
+                sim_PIR4.bits.CCP5IF = 1;
+                if (sim_ADCON0.bits.ADON)
+                    sim_ADCON0.bits.GO = 1;
+            } else {
+                t16_flag(i);
+            }
+            sim.t16[i].tmr = 0;
+        }
+        *t16_l[i] = (unsigned char)sim.t16[i].tmr;
+        *t16_h[i] = (unsigned char)(sim.t16[i].tmr >> 8);
+        sim.t16[i].seen_l = *t16_l[i];
+        sim.t16[i].seen_h = *t16_h[i];
+    }
+}
+
+// ------------------------------------------------------------
+// ADC
+// ------------------------------------------------------------
+
+// TAD in Fosc clocks for each ADCS code (FRC is roughly 1.7 us)
+static const unsigned char adc_tad_fosc[8] = { 2, 8, 32, 28, 4, 16, 64, 28 };
+static const unsigned char adc_acqt_tad[8] = { 0, 2, 4, 6, 8, 12, 16, 20 };
+
+static void adc_sync(void) {
+    if (!sim_ADCON0.bits.ADON || !sim_ADCON0.bits.GO) {
+        sim.adc_busy = 0;
+        return;
+    }
+    if (sim.adc_busy)
+        return;
+    unsigned int tad = adc_tad_fosc[sim_ADCON2.bits.ADCS];
+    unsigned int fosc = (adc_acqt_tad[sim_ADCON2.bits.ACQT] + 11u) * tad;
+    sim.adc_busy = 1;
+    sim.adc_done_at = sim.cycles + (fosc + 3u) / 4u;
+}
+
+static void adc_run(void) {
+    if (!sim.adc_busy || sim.cycles < sim.adc_done_at)
+        return;
+
+    int64_t uv = (int64_t)sim.adc_uv[sim_ADCON0.bits.CHS];
+    if (sim.adc_noise_uv) {
+        sim.adc_seed = sim.adc_seed * 1103515245u + 12345u;
+        uv += (int64_t)((sim.adc_seed >> 8) % (2u * sim.adc_noise_uv + 1u)) - (int64_t)sim.adc_noise_uv;
+        if (uv < 0) uv = 0;
+    }
+    uint64_t vref = (uint64_t)sim.vdd_mv * 1000u;
+    unsigned long code = (unsigned long)(((uint64_t)uv * 1024u + vref / 2u) / vref);
+    if (code > 1023ul) code = 1023ul;
+
+    if (sim_ADCON2.bits.ADFM) {                 // right justified
+        sim_ADRESH.byte = (unsigned char)(code >> 8);
+        sim_ADRESL.byte = (unsigned char)code;
+    } else {                                    // left justified
+        sim_ADRESH.byte = (unsigned char)(code >> 2);
+        sim_ADRESL.byte = (unsigned char)(code << 6);
+    }
+    sim_ADCON0.bits.GO = 0;
+    sim_PIR1.bits.ADIF = 1;
+    sim.adc_busy = 0;
+}
+
+static uint64_t adc_cycles_to_done(void) {
+    return sim.adc_busy ? sim.adc_done_at - sim.cycles : UINT64_MAX;
+}
+
+// ------------------------------------------------------------
+// Data EEPROM
+// ------------------------------------------------------------
+// RD copies the addressed byte to EEDATA at once.  WR only starts a
+// write when WREN is set and 0x55, 0xAA were written to EECON2 just
+// before; the byte lands SIM_EE_WRITE_US later, when WR clears and
+// EEIF is set.  EECON2 reads back 0 so repeated writes are seen.
+#define SIM_EE_WRITE_US 4000u
+
+static void ee_sync(void) {
+    if (sim_EECON2.byte) {
+        if (sim_EECON2.byte == 0x55) sim.ee_unlock = 1;
+        else if (sim_EECON2.byte == 0xAA && sim.ee_unlock == 1) sim.ee_unlock = 2;
+        else sim.ee_unlock = 0;
+        sim_EECON2.byte = 0;
+    }
+    if (sim_EECON1.bits.RD) {
+        if (!sim_EECON1.bits.EEPGD && !sim_EECON1.bits.CFGS)
+            sim_EEDATA.byte = sim.ee[sim_EEADR.byte];
+        sim_EECON1.bits.RD = 0;
+    }
+    if (sim_EECON1.bits.WR && !sim.ee_busy) {
+        if (sim_EECON1.bits.WREN && sim.ee_unlock == 2 &&
+            !sim_EECON1.bits.EEPGD && !sim_EECON1.bits.CFGS) {
+            sim.ee_busy = 1;
+            sim.ee_addr = sim_EEADR.byte;
+            sim.ee_data = sim_EEDATA.byte;
+            sim.ee_done_at = sim.cycles + SIM_EE_WRITE_US * SIM_TCY_PER_US;
+        } else {
+            sim_EECON1.bits.WR = 0;     // not unlocked: ignored
+        }
+        sim.ee_unlock = 0;
+    }
+}
+
+static void ee_run(void) {
+    if (!sim.ee_busy || sim.cycles < sim.ee_done_at)
+        return;
+    sim.ee[sim.ee_addr] = sim.ee_data;
+    sim.ee_writes++;
+    sim.ee_busy = 0;
+    sim_EECON1.bits.WR = 0;
+    sim_PIR2.bits.EEIF = 1;
+}
+
+static uint64_t ee_cycles_to_done(void) {
+    return sim.ee_busy ? sim.ee_done_at - sim.cycles : UINT64_MAX;
+}
+
+unsigned char sim_eeprom_peek(unsigned char addr) {
+    return sim.ee[addr];
+}
+
+unsigned long sim_eeprom_writes(void) {
+    return sim.ee_writes;
+}
+
+// ------------------------------------------------------------
+// Interrupts
+// ------------------------------------------------------------
+static int irq_pending(void) {
+    unsigned char intcon = sim_INTCON.byte;
+    if ((intcon & 0x20) && (intcon & 0x04)) return 1;   // TMR0
+    if ((intcon & 0x10) && (intcon & 0x02)) return 1;   // INT0
+    if ((intcon & 0x08) && (intcon & 0x01)) return 1;   // RB change
+    if (sim_INTCON3.byte & (sim_INTCON3.byte >> 3) & 0x03) return 1;  // INT1, INT2
+    if ((intcon & 0x40) && (sim_PIR1.byte & sim_PIE1.byte)) return 1;
+    if ((intcon & 0x40) && (sim_PIR2.byte & sim_PIE2.byte)) return 1;
+    if ((intcon & 0x40) && (sim_PIR4.byte & sim_PIE4.byte)) return 1;
+    if ((intcon & 0x40) && (sim_PIR5.byte & sim_PIE5.byte)) return 1;
+    return 0;
+}
+
+// Any flag whose enable bit is set ends SLEEP, whatever GIE and PEIE say
+static int wake_pending(void) {
+    unsigned char intcon = sim_INTCON.byte;
+    return (intcon & (intcon >> 3) & 0x07)
+        || (sim_INTCON3.byte & (sim_INTCON3.byte >> 3) & 0x03)
+        || (sim_PIR1.byte & sim_PIE1.byte) || (sim_PIR2.byte & sim_PIE2.byte)
+        || (sim_PIR4.byte & sim_PIE4.byte) || (sim_PIR5.byte & sim_PIE5.byte);
+}
+
+static void irq_dispatch(void) {
+    if (sim.in_isr || !sim.isr || !sim_INTCON.bits.GIE || !irq_pending())
+        return;
+    sim.in_isr = 1;
+    sim_INTCON.bits.GIE = 0;
+    sim_delay_cycles(3);            // vectoring latency
+    sim.isr();
+    sim_delay_cycles(2);            // RETFIE
+    sim_INTCON.bits.GIE = 1;
+    sim.in_isr = 0;
+}
+
+// ------------------------------------------------------------
+// Scheduled pin changes
+// ------------------------------------------------------------
+static uint64_t stim_cycles_to_next(void) {
+    uint64_t next = UINT64_MAX;
+    for (int i = 0; i < SIM_STIM_MAX; i++)
+        if (sim.stim[i].at && sim.stim[i].at - sim.cycles < next)
+            next = sim.stim[i].at - sim.cycles;
+    return next;
+}
+
+static void stim_run(void) {
+    int changed = 0;
+    for (int i = 0; i < SIM_STIM_MAX; i++) {
+        if (sim.stim[i].at && sim.stim[i].at <= sim.cycles) {
+            sim_set_pin(sim.stim[i].port, sim.stim[i].bit, sim.stim[i].level);
+            sim.stim[i].at = 0;
+            changed = 1;
+        }
+    }
+    if (changed)
+        ports_sync();
+}
+
+// ------------------------------------------------------------
+// Clock
+// ------------------------------------------------------------
+// In Sleep (clock_off) only the scheduled pins and a data EEPROM write
+// still move; a wake-up ends the call early, after the interrupt (if
+// GIE) has been taken.
+static void advance(uint64_t n) {
+    while (n) {
+        uint64_t step = n;
+        uint64_t ee = ee_cycles_to_done();
+        uint64_t st = stim_cycles_to_next();
+        if (ee < step) step = ee;
+        if (st < step) step = st;
+        if (!sim.clock_off) {
+            uint64_t t0 = t0_cycles_to_overflow();
+            uint64_t ad = adc_cycles_to_done();
+            uint64_t t8 = t8_cycles_to_match();
+            uint64_t t16 = t16_cycles_to_event();
+            if (t0 < step) step = t0;
+            if (t8 < step) step = t8;
+            if (t16 < step) step = t16;
+            if (ad < step) step = ad;
+        }
+        if (sim.limit && sim.limit - sim.cycles < step) step = sim.limit - sim.cycles;
+        if (step == 0) step = 1;
+
+        sim.cycles += step;
+        n -= step;
+        if (!sim.clock_off) {
+            t0_run(step);
+            t8_run(step);
+            t16_run(step);
+            adc_run();
+            adc_sync();             // a special event may have set GO
+        }
+        ee_run();
+        stim_run();
+
+        if (sim.limit && sim.cycles >= sim.limit) {
+            sim_report();
+            exit(0);
+        }
+        int wake = sim.asleep && wake_pending();
+        if (wake) {
+            sim.asleep = 0;
+            sim.clock_off = 0;
+        }
+        irq_dispatch();
+        if (wake)
+            return;
+    }
+}
+
+static void sync_all(void) {
+    if (!sim.started)
+        sim_start();
+    ports_sync();
+    outputs_sync();
+    t0_sync();
+    t8_sync();
+    t16_sync();
+    adc_sync();
+    ee_sync();
+}
+
+void sim_touch(void) {
+    sync_all();
+    advance(1);
+}
+
+void sim_delay_cycles(unsigned long n) {
+    sync_all();
+    advance(n);
+}
+
+// Runs until an enabled interrupt flag is raised. Asleep with nothing
+// left that could raise one, the run ends as at the time limit.
+void sim_sleep(void) {
+    sync_all();
+    advance(1);                     // the SLEEP instruction
+    if (wake_pending())
+        return;
+    sim.asleep = 1;
+    sim.clock_off = !sim_OSCCON.bits.IDLEN;
+    while (sim.asleep) {
+        if (sim.clock_off && !sim.limit && !sim.ee_busy &&
+            stim_cycles_to_next() == UINT64_MAX) {
+            printf("sim: asleep with no wake-up source left\n");
+            sim_report();
+            exit(0);
+        }
+        advance(SIM_FOSC / 4);      // a second at a time
+    }
+    sync_all();
+}
+
+uint64_t sim_cycles(void) {
+    return sim.cycles;
+}
+
+void sim_set_time_limit_us(uint64_t us) {
+    if (!sim.started)
+        sim_start();
+    sim.limit = us ? sim.cycles + us * SIM_TCY_PER_US : 0;
+}
+
+void sim_set_isr(void (*isr)(void)) {
+    sim.isr = isr;
+}
+
+// ------------------------------------------------------------
+// Stimulus
+// ------------------------------------------------------------
+void sim_set_pins(unsigned char port, unsigned char level) {
+    if (port < SIM_NPORTS) sim.pin_in[port] = level;
+}
+
+void sim_set_pin(unsigned char port, unsigned char bit, unsigned char level) {
+    if (port >= SIM_NPORTS) return;
+    if (level) sim.pin_in[port] |= (unsigned char)(1u << bit);
+    else       sim.pin_in[port] &= (unsigned char)~(1u << bit);
+}
+
+void sim_set_pin_after(uint64_t us, unsigned char port, unsigned char bit, unsigned char level) {
+    if (!sim.started)
+        sim_start();
+    for (int i = 0; i < SIM_STIM_MAX; i++) {
+        if (!sim.stim[i].at) {
+            sim.stim[i].at = sim.cycles + (us ? us * SIM_TCY_PER_US : 1);
+            sim.stim[i].port = port;
+            sim.stim[i].bit = bit;
+            sim.stim[i].level = level;
+            return;
+        }
+    }
+    fprintf(stderr, "sim: more than %d pin changes scheduled\n", SIM_STIM_MAX);
+    exit(2);
+}
+
+void sim_adc_set_mv(unsigned char channel, unsigned int mv) {
+    if (channel < 32) sim.adc_uv[channel] = mv * 1000ul;
+}
+
+// LM35: 10 mV per degree, so one T100 step (0.01 C) is 100 uV
+void sim_lm35_set_t100(unsigned char channel, unsigned int t100) {
+    if (channel < 32) sim.adc_uv[channel] = t100 * 100ul;
+}
+
+// Uniform noise of +-uv on every conversion (repeatable sequence)
+void sim_adc_set_noise_uv(unsigned long uv) {
+    sim.adc_noise_uv = uv;
+    sim.adc_seed = 1u;
+}
+
+void sim_set_vdd_mv(unsigned int mv) {
+    sim.vdd_mv = mv ? mv : SIM_VDD_MV;
+}
+
+// ------------------------------------------------------------
+// Setup and reporting
+// ------------------------------------------------------------
+
+// SIM_SECONDS limits how long a free-running lab executes (default 2 s).
+// SIM_ADC_MV="6=250,0=1200" sets analogue inputs in millivolts.
+// SIM_ADC_NOISE_UV=2500 adds +-2.5 mV of noise to every conversion.
+static void sim_start(void) {
+    sim.started = 1;
+    if (!sim.vdd_mv)
+        sim.vdd_mv = SIM_VDD_MV;
+    memset(sim.pin_in, 0xFF, sizeof sim.pin_in);   // buttons released
+    memset(sim.ee, 0xFF, sizeof sim.ee);           // erased EEPROM
+    if (!sim.adc_uv[6])
+        sim.adc_uv[6] = 250000ul;                  // LM35 at 25 C
+
+    const char *secs = getenv("SIM_SECONDS");
+    double s = secs ? atof(secs) : 2.0;
+    sim.limit = s > 0 ? (uint64_t)(s * (SIM_FOSC / 4)) : 0;
+
+    const char *mv = getenv("SIM_ADC_MV");
+    while (mv && *mv) {
+        char *end;
+        long ch = strtol(mv, &end, 10);
+        if (*end != '=') break;
+        long v = strtol(end + 1, &end, 10);
+        sim_adc_set_mv((unsigned char)ch, (unsigned int)v);
+        mv = (*end == ',') ? end + 1 : NULL;
+    }
+
+    const char *noise = getenv("SIM_ADC_NOISE_UV");
+    if (noise)
+        sim_adc_set_noise_uv(strtoul(noise, NULL, 10));
+}
+
+void sim_reset(void) {
+    uint64_t limit = sim.limit;
+    void (*isr)(void) = sim.isr;
+    memset(&sim, 0, sizeof sim);
+    sim_start();
+    sim.limit = limit;
+    sim.isr = isr;
+
+    for (int p = 0; p < SIM_NPORTS; p++) {
+        *port_reg[p] = 0;
+        *lat_reg[p] = 0;
+        *tris_reg[p] = 0xFF;
+    }
+    sim_ANSELA.byte = 0x2F; sim_ANSELB.byte = 0x3F; sim_ANSELC.byte = 0xFC;
+    sim_ANSELD.byte = 0xFF; sim_ANSELE.byte = 0x07;
+    sim_ADCON0.byte = 0; sim_ADCON1.byte = 0; sim_ADCON2.byte = 0;
+    sim_ADRESH.byte = 0; sim_ADRESL.byte = 0;
+    sim_T0CON.byte = 0xFF; sim_TMR0H.byte = 0; sim_TMR0L.byte = 0;
+    sim_INTCON.byte = 0; sim_INTCON2.byte = 0xF5; sim_INTCON3.byte = 0xC0;
+    sim_IOCB.byte = 0xF0;
+    sim_PIR1.byte = 0; sim_PIE1.byte = 0;
+    sim_PIR2.byte = 0; sim_PIE2.byte = 0;
+    sim_PIR4.byte = 0; sim_PIE4.byte = 0;
+    sim_PIR5.byte = 0; sim_PIE5.byte = 0;
+    sim_T2CON.byte = 0; sim_T4CON.byte = 0; sim_T6CON.byte = 0;
+    sim_TMR2.byte = 0; sim_TMR4.byte = 0; sim_TMR6.byte = 0;
+    sim_PR2.byte = 0xFF; sim_PR4.byte = 0xFF; sim_PR6.byte = 0xFF;
+    sim_T1CON.byte = 0; sim_T3CON.byte = 0; sim_T5CON.byte = 0;
+    sim_TMR1H.byte = 0; sim_TMR1L.byte = 0; sim_TMR3H.byte = 0;
+    sim_TMR3L.byte = 0; sim_TMR5H.byte = 0; sim_TMR5L.byte = 0;
+    sim_CCP1CON.byte = 0; sim_CCPR1H.byte = 0; sim_CCPR1L.byte = 0;
+    sim_CCPTMRS0.byte = 0;
+    sim_CCP5CON.byte = 0; sim_CCPR5H.byte = 0; sim_CCPR5L.byte = 0;
+    sim_CCPTMRS1.byte = 0;
+    sim_EECON1.byte = 0; sim_EECON2.byte = 0; sim_EEADR.byte = 0; sim_EEDATA.byte = 0;
+    sim_OSCCON.byte = 0x30;
+    sim_CM1CON0.byte = 0; sim_CM2CON0.byte = 0;
+    hd44780_reset();
+}
+
+unsigned long sim_buzzer_edges(void) {
+    return sim.buz_edges;
+}
+
+unsigned long sim_buzzer_freq_hz(void) {
+    return sim.buz_period ? (unsigned long)((SIM_FOSC / 4) / sim.buz_period) : 0;
+}
+
+// PWM is averaged over its period rather than followed edge by edge
+unsigned char sim_buzzer_level(void) {
+    if (sim_TRISC.byte & 0x04)
+        return 0;
+    if (sim_CCP1CON.bits.CCP1M >= 0x0C) {
+        unsigned char t = sim_CCPTMRS0.bits.C1TSEL < 3 ? sim_CCPTMRS0.bits.C1TSEL : 0;
+        unsigned int period = 4u * ((unsigned int)*t8_pr[t] + 1u);
+        unsigned int duty = ((unsigned int)sim_CCPR1L.byte << 2) | sim_CCP1CON.bits.DC1B;
+        return duty >= period ? 255 : (unsigned char)(duty * 256u / period);
+    }
+    return (sim_PORTC.byte & 0x04) ? 255 : 0;
+}
+
+void sim_report(void) {
+    printf("sim: %.3f ms (%llu Tcy)\n", (double)sim.cycles / (SIM_FOSC / 4000.0),
+           (unsigned long long)sim.cycles);
+    printf("sim: LATA=%02X LATB=%02X LATC=%02X LATD=%02X LATE=%02X\n",
+           sim_LATA.byte, sim_LATB.byte, sim_LATC.byte, sim_LATD.byte, sim_LATE.byte);
+    if (sim.buz_edges)
+        printf("sim: RC2/buzzer %lu edges, last %lu Hz\n", sim.buz_edges, sim_buzzer_freq_hz());
+    if (hd44780_attached()) {
+        char line[17];
+        sim_lcd_stats_t st;
+        sim_lcd_get_stats(&st);
+        sim_lcd_line(0, line);
+        printf("sim: LCD |%s|\n", line);
+        sim_lcd_line(1, line);
+        printf("sim: LCD |%s|\n", line);
+        printf("sim: LCD %lu writes, %lu reads, %lu cmds, %lu chars, %lu busy violations\n",
+               st.pulses, st.reads, st.commands, st.chars, st.violations);
+    }
+}
@@ -0,0 +1,429 @@
+// pic18_sim.h
+// Host-side register model of the PIC18(L)F4XK22 used by the labs.
+//
+// Every SFR the lab code touches is a global union with a .byte view and a
+// .bits view, so LATC = 0x01 and PORTBbits.RB0 compile unchanged.  Each
+// register access goes through sim_touch(), which costs one instruction
+// cycle and lets the peripheral models (ports, timers, CCP5, ADC, HD44780,
+// buzzer pin) catch up with what the firmware wrote last.  Delays advance
+// the virtual cycle clock instead of spinning.
+
+#ifndef PIC18_SIM_H
+#define PIC18_SIM_H
+
+#include <stdint.h>
+
+#define SIM_FOSC 16000000UL          // 16 MHz internal oscillator
+#define SIM_TCY_PER_US (SIM_FOSC / 4000000UL)
+
+// Port indices used by the sim_* API
+enum { SIM_PORTA, SIM_PORTB, SIM_PORTC, SIM_PORTD, SIM_PORTE, SIM_NPORTS };
+
+// ------------------------------------------------------------
+// Register layout
+// ------------------------------------------------------------
+#define SIM_BITS8(p) struct { \
+    unsigned p##0:1; unsigned p##1:1; unsigned p##2:1; unsigned p##3:1; \
+    unsigned p##4:1; unsigned p##5:1; unsigned p##6:1; unsigned p##7:1; }
+
+#define SIM_PORT_TYPES(x) \
+    typedef union { unsigned char byte; SIM_BITS8(R##x) bits; } PORT##x##bits_t; \
+    typedef union { unsigned char byte; SIM_BITS8(LAT##x) bits; } LAT##x##bits_t; \
+    typedef union { unsigned char byte; SIM_BITS8(TRIS##x) bits; } TRIS##x##bits_t; \
+    typedef union { unsigned char byte; SIM_BITS8(ANS##x) bits; } ANSEL##x##bits_t;
+
+SIM_PORT_TYPES(A)
+SIM_PORT_TYPES(B)
+SIM_PORT_TYPES(C)
+SIM_PORT_TYPES(D)
+SIM_PORT_TYPES(E)
+
+typedef union { unsigned char byte; union {
+    struct { unsigned ADON:1; unsigned GO:1; unsigned CHS:5; unsigned :1; };
+    struct { unsigned :1; unsigned GO_nDONE:1; };
+    struct { unsigned :1; unsigned DONE:1; };
+} bits; } ADCON0bits_t;
+
+typedef union { unsigned char byte; struct {
+    unsigned NVCFG:2; unsigned PVCFG:2; unsigned :3; unsigned TRIGSEL:1;
+} bits; } ADCON1bits_t;
+
+typedef union { unsigned char byte; struct {
+    unsigned ADCS:3; unsigned ACQT:3; unsigned :1; unsigned ADFM:1;
+} bits; } ADCON2bits_t;
+
+typedef union { unsigned char byte; struct {
+    unsigned T0PS:3; unsigned PSA:1; unsigned T0SE:1; unsigned T0CS:1;
+    unsigned T08BIT:1; unsigned TMR0ON:1;
+} bits; } T0CONbits_t;
+
+typedef union { unsigned char byte; union {
+    struct { unsigned RBIF:1; unsigned INT0IF:1; unsigned TMR0IF:1; unsigned RBIE:1;
+             unsigned INT0IE:1; unsigned TMR0IE:1; unsigned PEIE:1; unsigned GIE:1; };
+    struct { unsigned :1; unsigned INT0F:1; unsigned T0IF:1; unsigned :1;
+             unsigned INT0E:1; unsigned T0IE:1; unsigned GIEL:1; unsigned GIEH:1; };
+} bits; } INTCONbits_t;
+
+typedef union { unsigned char byte; struct {
+    unsigned RBIP:1; unsigned :1; unsigned TMR0IP:1; unsigned :1;
+    unsigned INTEDG2:1; unsigned INTEDG1:1; unsigned INTEDG0:1; unsigned nRBPU:1;
+} bits; } INTCON2bits_t;
+
+typedef union { unsigned char byte; struct {
+    unsigned INT1IF:1; unsigned INT2IF:1; unsigned :1; unsigned INT1IE:1;
+    unsigned INT2IE:1; unsigned :1; unsigned INT1IP:1; unsigned INT2IP:1;
+} bits; } INTCON3bits_t;
+
+typedef union { unsigned char byte; struct {
+    unsigned :4; unsigned IOCB4:1; unsigned IOCB5:1; unsigned IOCB6:1; unsigned IOCB7:1;
+} bits; } IOCBbits_t;
+
+typedef union { unsigned char byte; struct {
+    unsigned TMR1IF:1; unsigned TMR2IF:1; unsigned CCP1IF:1; unsigned SSP1IF:1;
+    unsigned TX1IF:1; unsigned RC1IF:1; unsigned ADIF:1; unsigned :1;
+} bits; } PIR1bits_t;
+
+typedef union { unsigned char byte; struct {
+    unsigned TMR1IE:1; unsigned TMR2IE:1; unsigned CCP1IE:1; unsigned SSP1IE:1;
+    unsigned TX1IE:1; unsigned RC1IE:1; unsigned ADIE:1; unsigned :1;
+} bits; } PIE1bits_t;
+
+typedef union { unsigned char byte; struct {
+    unsigned CCP2IF:1; unsigned TMR3IF:1; unsigned HLVDIF:1; unsigned BCL1IF:1;
+    unsigned EEIF:1; unsigned C2IF:1; unsigned C1IF:1; unsigned OSCFIF:1;
+} bits; } PIR2bits_t;
+
+typedef union { unsigned char byte; struct {
+    unsigned CCP2IE:1; unsigned TMR3IE:1; unsigned HLVDIE:1; unsigned BCL1IE:1;
+    unsigned EEIE:1; unsigned C2IE:1; unsigned C1IE:1; unsigned OSCFIE:1;
+} bits; } PIE2bits_t;
+
+typedef union { unsigned char byte; struct {
+    unsigned CCP3IF:1; unsigned CCP4IF:1; unsigned CCP5IF:1; unsigned :5;
+} bits; } PIR4bits_t;
+
+typedef union { unsigned char byte; struct {
+    unsigned CCP3IE:1; unsigned CCP4IE:1; unsigned CCP5IE:1; unsigned :5;
+} bits; } PIE4bits_t;
+
+typedef union { unsigned char byte; struct {
+    unsigned TMR4IF:1; unsigned TMR5IF:1; unsigned TMR6IF:1; unsigned :5;
+} bits; } PIR5bits_t;
+
+typedef union { unsigned char byte; struct {
+    unsigned TMR4IE:1; unsigned TMR5IE:1; unsigned TMR6IE:1; unsigned :5;
+} bits; } PIE5bits_t;
+
+// T1CON / T3CON / T5CON share one layout (external clock not modelled)
+#define SIM_T16CON_TYPE(n) \
+    typedef union { unsigned char byte; struct { \
+        unsigned TMR##n##ON:1; unsigned T##n##RD16:1; unsigned nT##n##SYNC:1; \
+        unsigned T##n##SOSCEN:1; unsigned T##n##CKPS:2; unsigned TMR##n##CS:2; \
+    } bits; } T##n##CONbits_t;
+SIM_T16CON_TYPE(1)
+SIM_T16CON_TYPE(3)
+SIM_T16CON_TYPE(5)
+
+typedef union { unsigned char byte; struct {
+    unsigned CCP5M:4; unsigned DC5B:2; unsigned :2;
+} bits; } CCP5CONbits_t;
+
+typedef union { unsigned char byte; struct {
+    unsigned CCP1M:4; unsigned DC1B:2; unsigned P1M:2;
+} bits; } CCP1CONbits_t;
+
+typedef union { unsigned char byte; struct {
+    unsigned C1TSEL:2; unsigned :1; unsigned C2TSEL:2; unsigned :1; unsigned C3TSEL:2;
+} bits; } CCPTMRS0bits_t;
+
+typedef union { unsigned char byte; struct {
+    unsigned C4TSEL:2; unsigned C5TSEL:2; unsigned :4;
+} bits; } CCPTMRS1bits_t;
+
+// T2CON / T4CON / T6CON share one layout
+#define SIM_TXCON_TYPE(n) \
+    typedef union { unsigned char byte; struct { \
+        unsigned T##n##CKPS:2; unsigned TMR##n##ON:1; unsigned T##n##OUTPS:4; unsigned :1; \
+    } bits; } T##n##CONbits_t;
+SIM_TXCON_TYPE(2)
+SIM_TXCON_TYPE(4)
+SIM_TXCON_TYPE(6)
+
+typedef union { unsigned char byte; struct {
+    unsigned RD:1; unsigned WR:1; unsigned WREN:1; unsigned WRERR:1;
+    unsigned FREE:1; unsigned :1; unsigned CFGS:1; unsigned EEPGD:1;
+} bits; } EECON1bits_t;
+
+typedef union { unsigned char byte; struct {
+    unsigned SCS:2; unsigned HFIOFS:1; unsigned OSTS:1; unsigned IRCF:3; unsigned IDLEN:1;
+} bits; } OSCCONbits_t;
+
+typedef union { unsigned char byte; SIM_BITS8(B) bits; } SIMREG8bits_t;
+
+#define SIM_PORT_REGS(x) \
+    extern volatile PORT##x##bits_t sim_PORT##x; \
+    extern volatile LAT##x##bits_t sim_LAT##x; \
+    extern volatile TRIS##x##bits_t sim_TRIS##x; \
+    extern volatile ANSEL##x##bits_t sim_ANSEL##x;
+
+SIM_PORT_REGS(A)
+SIM_PORT_REGS(B)
+SIM_PORT_REGS(C)
+SIM_PORT_REGS(D)
+SIM_PORT_REGS(E)
+
+extern volatile ADCON0bits_t sim_ADCON0;
+extern volatile ADCON1bits_t sim_ADCON1;
+extern volatile ADCON2bits_t sim_ADCON2;
+extern volatile SIMREG8bits_t sim_ADRESH, sim_ADRESL;
+extern volatile T0CONbits_t sim_T0CON;
+extern volatile SIMREG8bits_t sim_TMR0H, sim_TMR0L;
+extern volatile INTCONbits_t sim_INTCON;
+extern volatile INTCON2bits_t sim_INTCON2;
+extern volatile INTCON3bits_t sim_INTCON3;
+extern volatile IOCBbits_t sim_IOCB;
+extern volatile PIR1bits_t sim_PIR1;
+extern volatile PIE1bits_t sim_PIE1;
+extern volatile PIR2bits_t sim_PIR2;
+extern volatile PIE2bits_t sim_PIE2;
+extern volatile PIR4bits_t sim_PIR4;
+extern volatile PIE4bits_t sim_PIE4;
+extern volatile PIR5bits_t sim_PIR5;
+extern volatile PIE5bits_t sim_PIE5;
+extern volatile T2CONbits_t sim_T2CON;
+extern volatile T4CONbits_t sim_T4CON;
+extern volatile T6CONbits_t sim_T6CON;
+extern volatile SIMREG8bits_t sim_TMR2, sim_PR2, sim_TMR4, sim_PR4, sim_TMR6, sim_PR6;
+extern volatile T1CONbits_t sim_T1CON;
+extern volatile T3CONbits_t sim_T3CON;
+extern volatile T5CONbits_t sim_T5CON;
+extern volatile SIMREG8bits_t sim_TMR1H, sim_TMR1L, sim_TMR3H, sim_TMR3L, sim_TMR5H, sim_TMR5L;
+extern volatile CCP1CONbits_t sim_CCP1CON;
+extern volatile SIMREG8bits_t sim_CCPR1H, sim_CCPR1L;
+extern volatile CCPTMRS0bits_t sim_CCPTMRS0;
+extern volatile CCP5CONbits_t sim_CCP5CON;
+extern volatile SIMREG8bits_t sim_CCPR5H, sim_CCPR5L;
+extern volatile CCPTMRS1bits_t sim_CCPTMRS1;
+extern volatile EECON1bits_t sim_EECON1;
+extern volatile SIMREG8bits_t sim_EECON2, sim_EEADR, sim_EEDATA;
+extern volatile OSCCONbits_t sim_OSCCON;
+extern volatile SIMREG8bits_t sim_CM1CON0, sim_CM2CON0;
+
+// ------------------------------------------------------------
+// XC8-style names.  Every access costs one instruction cycle.
+// ------------------------------------------------------------
+#define SIM_REG(r) (*(sim_touch(), &(r)))
+
+#define PORTA      SIM_REG(sim_PORTA).byte
+#define PORTAbits  SIM_REG(sim_PORTA).bits
+#define LATA       SIM_REG(sim_LATA).byte
+#define LATAbits   SIM_REG(sim_LATA).bits
+#define TRISA      SIM_REG(sim_TRISA).byte
+#define TRISAbits  SIM_REG(sim_TRISA).bits
+#define ANSELA     SIM_REG(sim_ANSELA).byte
+#define ANSELAbits SIM_REG(sim_ANSELA).bits
+
+#define PORTB      SIM_REG(sim_PORTB).byte
+#define PORTBbits  SIM_REG(sim_PORTB).bits
+#define LATB       SIM_REG(sim_LATB).byte
+#define LATBbits   SIM_REG(sim_LATB).bits
+#define TRISB      SIM_REG(sim_TRISB).byte
+#define TRISBbits  SIM_REG(sim_TRISB).bits
+#define ANSELB     SIM_REG(sim_ANSELB).byte
+#define ANSELBbits SIM_REG(sim_ANSELB).bits
+
+#define PORTC      SIM_REG(sim_PORTC).byte
+#define PORTCbits  SIM_REG(sim_PORTC).bits
+#define LATC       SIM_REG(sim_LATC).byte
+#define LATCbits   SIM_REG(sim_LATC).bits
+#define TRISC      SIM_REG(sim_TRISC).byte
+#define TRISCbits  SIM_REG(sim_TRISC).bits
+#define ANSELC     SIM_REG(sim_ANSELC).byte
+#define ANSELCbits SIM_REG(sim_ANSELC).bits
+
+#define PORTD      SIM_REG(sim_PORTD).byte
+#define PORTDbits  SIM_REG(sim_PORTD).bits
+#define LATD       SIM_REG(sim_LATD).byte
+#define LATDbits   SIM_REG(sim_LATD).bits
+#define TRISD      SIM_REG(sim_TRISD).byte
+#define TRISDbits  SIM_REG(sim_TRISD).bits
+#define ANSELD     SIM_REG(sim_ANSELD).byte
+#define ANSELDbits SIM_REG(sim_ANSELD).bits
+
+#define PORTE      SIM_REG(sim_PORTE).byte
+#define PORTEbits  SIM_REG(sim_PORTE).bits
+#define LATE       SIM_REG(sim_LATE).byte
+#define LATEbits   SIM_REG(sim_LATE).bits
+#define TRISE      SIM_REG(sim_TRISE).byte
+#define TRISEbits  SIM_REG(sim_TRISE).bits
+#define ANSELE     SIM_REG(sim_ANSELE).byte
+#define ANSELEbits SIM_REG(sim_ANSELE).bits
+
+#define ADCON0     SIM_REG(sim_ADCON0).byte
+#define ADCON0bits SIM_REG(sim_ADCON0).bits
+#define ADCON1     SIM_REG(sim_ADCON1).byte
+#define ADCON1bits SIM_REG(sim_ADCON1).bits
+#define ADCON2     SIM_REG(sim_ADCON2).byte
+#define ADCON2bits SIM_REG(sim_ADCON2).bits
+#define ADRESH     SIM_REG(sim_ADRESH).byte
+#define ADRESL     SIM_REG(sim_ADRESL).byte
+
+#define T0CON      SIM_REG(sim_T0CON).byte
+#define T0CONbits  SIM_REG(sim_T0CON).bits
+#define TMR0H      SIM_REG(sim_TMR0H).byte
+#define TMR0L      SIM_REG(sim_TMR0L).byte
+
+#define INTCON      SIM_REG(sim_INTCON).byte
+#define INTCONbits  SIM_REG(sim_INTCON).bits
+#define INTCON2     SIM_REG(sim_INTCON2).byte
+#define INTCON2bits SIM_REG(sim_INTCON2).bits
+#define INTCON3     SIM_REG(sim_INTCON3).byte
+#define INTCON3bits SIM_REG(sim_INTCON3).bits
+#define IOCB        SIM_REG(sim_IOCB).byte
+#define IOCBbits    SIM_REG(sim_IOCB).bits
+#define PIR1        SIM_REG(sim_PIR1).byte
+#define PIR1bits    SIM_REG(sim_PIR1).bits
+#define PIE1        SIM_REG(sim_PIE1).byte
+#define PIE1bits    SIM_REG(sim_PIE1).bits
+
+#define PIR2        SIM_REG(sim_PIR2).byte
+#define PIR2bits    SIM_REG(sim_PIR2).bits
+#define PIE2        SIM_REG(sim_PIE2).byte
+#define PIE2bits    SIM_REG(sim_PIE2).bits
+#define PIR4        SIM_REG(sim_PIR4).byte
+#define PIR4bits    SIM_REG(sim_PIR4).bits
+#define PIE4        SIM_REG(sim_PIE4).byte
+#define PIE4bits    SIM_REG(sim_PIE4).bits
+#define PIR5        SIM_REG(sim_PIR5).byte
+#define PIR5bits    SIM_REG(sim_PIR5).bits
+#define PIE5        SIM_REG(sim_PIE5).byte
+#define PIE5bits    SIM_REG(sim_PIE5).bits
+
+#define T2CON      SIM_REG(sim_T2CON).byte
+#define T2CONbits  SIM_REG(sim_T2CON).bits
+#define TMR2       SIM_REG(sim_TMR2).byte
+#define PR2        SIM_REG(sim_PR2).byte
+#define T4CON      SIM_REG(sim_T4CON).byte
+#define T4CONbits  SIM_REG(sim_T4CON).bits
+#define TMR4       SIM_REG(sim_TMR4).byte
+#define PR4        SIM_REG(sim_PR4).byte
+#define T6CON      SIM_REG(sim_T6CON).byte
+#define T6CONbits  SIM_REG(sim_T6CON).bits
+#define TMR6       SIM_REG(sim_TMR6).byte
+#define PR6        SIM_REG(sim_PR6).byte
+
+#define T1CON      SIM_REG(sim_T1CON).byte
+#define T1CONbits  SIM_REG(sim_T1CON).bits
+#define TMR1H      SIM_REG(sim_TMR1H).byte
+#define TMR1L      SIM_REG(sim_TMR1L).byte
+#define T3CON      SIM_REG(sim_T3CON).byte
+#define T3CONbits  SIM_REG(sim_T3CON).bits
+#define TMR3H      SIM_REG(sim_TMR3H).byte
+#define TMR3L      SIM_REG(sim_TMR3L).byte
+#define T5CON      SIM_REG(sim_T5CON).byte
+#define T5CONbits  SIM_REG(sim_T5CON).bits
+#define TMR5H      SIM_REG(sim_TMR5H).byte
+#define TMR5L      SIM_REG(sim_TMR5L).byte
+
+#define CCP1CON      SIM_REG(sim_CCP1CON).byte
+#define CCP1CONbits  SIM_REG(sim_CCP1CON).bits
+#define CCPR1H       SIM_REG(sim_CCPR1H).byte
+#define CCPR1L       SIM_REG(sim_CCPR1L).byte
+#define CCPTMRS0     SIM_REG(sim_CCPTMRS0).byte
+#define CCPTMRS0bits SIM_REG(sim_CCPTMRS0).bits
+#define CCP5CON      SIM_REG(sim_CCP5CON).byte
+#define CCP5CONbits  SIM_REG(sim_CCP5CON).bits
+#define CCPR5H       SIM_REG(sim_CCPR5H).byte
+#define CCPR5L       SIM_REG(sim_CCPR5L).byte
+#define CCPTMRS1     SIM_REG(sim_CCPTMRS1).byte
+#define CCPTMRS1bits SIM_REG(sim_CCPTMRS1).bits
+
+#define EECON1     SIM_REG(sim_EECON1).byte
+#define EECON1bits SIM_REG(sim_EECON1).bits
+#define EECON2     SIM_REG(sim_EECON2).byte
+#define EEADR      SIM_REG(sim_EEADR).byte
+#define EEDATA     SIM_REG(sim_EEDATA).byte
+
+#define OSCCON     SIM_REG(sim_OSCCON).byte
+#define OSCCONbits SIM_REG(sim_OSCCON).bits
+#define CM1CON0    SIM_REG(sim_CM1CON0).byte
+#define CM2CON0    SIM_REG(sim_CM2CON0).byte
+
+// ------------------------------------------------------------
+// Compiler intrinsics
+// ------------------------------------------------------------
+#define __delay_ms(x) sim_delay_cycles((unsigned long)((x) * (_XTAL_FREQ / 4000.0)))
+#define __delay_us(x) sim_delay_cycles((unsigned long)((x) * (_XTAL_FREQ / 4000000.0)))
+#define NOP()         sim_delay_cycles(1)
+#define CLRWDT()      sim_delay_cycles(1)
+#define SLEEP()       sim_sleep()
+#define ei()          (INTCONbits.GIE = 1)
+#define di()          (INTCONbits.GIE = 0)
+
+// ------------------------------------------------------------
+// Simulator control (host code only)
+// ------------------------------------------------------------
+void sim_touch(void);
+void sim_delay_cycles(unsigned long n);
+void sim_reset(void);
+uint64_t sim_cycles(void);
+void sim_set_time_limit_us(uint64_t us);     // 0 = run forever
+void sim_set_isr(void (*isr)(void));
+void sim_report(void);
+
+// External pin levels seen on PORTx for pins configured as inputs
+void sim_set_pins(unsigned char port, unsigned char level);
+void sim_set_pin(unsigned char port, unsigned char bit, unsigned char level);
+// The same, applied 'us' from now even while the firmware sleeps
+void sim_set_pin_after(uint64_t us, unsigned char port, unsigned char bit, unsigned char level);
+
+// SLEEP: with OSCCON.IDLEN = 0 the clocked peripherals stop too
+void sim_sleep(void);
+
+// Analogue inputs
+void sim_adc_set_mv(unsigned char channel, unsigned int mv);
+void sim_lm35_set_t100(unsigned char channel, unsigned int t100);
+void sim_adc_set_noise_uv(unsigned long uv);
+void sim_set_vdd_mv(unsigned int mv);
+
+// HD44780 controller wired to the given port pins
+typedef struct {
+    unsigned char data_port;   // port carrying D4..D7 (or D0..D7)
+    unsigned char data_shift;  // bit position of D4 (4-bit) or D0 (8-bit)
+    unsigned char ctrl_port;   // port carrying RS / EN
+    unsigned char rs_bit;
+    unsigned char en_bit;
+    signed char rw_bit;        // -1 = R/W tied low (write only)
+    unsigned char bus8;        // 1 = all eight data lines wired
+} sim_lcd_wiring_t;
+
+typedef struct {
+    unsigned long pulses;      // write strobes seen on the bus
+    unsigned long reads;       // busy-flag / data read strobes
+    unsigned long commands;    // complete instruction bytes
+    unsigned long chars;       // complete data bytes
+    unsigned long violations;  // bytes written while the controller was busy
+} sim_lcd_stats_t;
+
+void sim_lcd_attach(const sim_lcd_wiring_t *w);
+void sim_lcd_line(unsigned char line, char out[17]);
+void sim_lcd_get_stats(sim_lcd_stats_t *s);
+void sim_lcd_clear_stats(void);
+
+// Data EEPROM (256 bytes, erased to 0xFF at start)
+#define SIM_EEPROM_SIZE 256
+unsigned char sim_eeprom_peek(unsigned char addr);
+unsigned long sim_eeprom_writes(void);
+
+// Buzzer output on RC2
+unsigned long sim_buzzer_edges(void);
+unsigned long sim_buzzer_freq_hz(void);
+unsigned char sim_buzzer_level(void);         // 0..255; CCP1 PWM: the duty
+
+// Internal hooks between the core and the HD44780 model
+void hd44780_reset(void);
+void hd44780_sync(const unsigned char lat[SIM_NPORTS]);
+unsigned char hd44780_drive(unsigned char port, unsigned char *level);
+int hd44780_attached(void);
+
+#endif // PIC18_SIM_H
@@ -1,93 +1,313 @@
-#include <xc.h>
+#include "hal.h"
 #define _XTAL_FREQ 16000000UL
 
-void CLEARLED() {
+// --------------------------------------------------
+// LED engine
+// Eight LEDs on RC0..RC7, each with its own 8-bit brightness,
+// driven by bit-angle modulation: a frame is eight slots, slot b
+// lasting BAM_UNIT_US << b, and in slot b each LED is on if bit b
+// of its brightness is set. The Timer0 interrupt writes the slot's
+// precomputed bit-plane to LATC and rearms; that is all it does,
+// except at the end of a frame (~10 ms), where it steps the
+// running pattern.
+// --------------------------------------------------
+#define LED_COUNT 8
+#define BAM_UNIT_US 39          // 255 units = 9.9 ms frames, 100 Hz
+
+// Timer0 reloads (1 us per count) for each slot
+static const unsigned int BAM_RELOAD[8] = {
+    (unsigned int)(0u - BAM_UNIT_US),       (unsigned int)(0u - BAM_UNIT_US * 2),
+    (unsigned int)(0u - BAM_UNIT_US * 4),   (unsigned int)(0u - BAM_UNIT_US * 8),
+    (unsigned int)(0u - BAM_UNIT_US * 16),  (unsigned int)(0u - BAM_UNIT_US * 32),
+    (unsigned int)(0u - BAM_UNIT_US * 64),  (unsigned int)(0u - BAM_UNIT_US * 128)
+};
+
+static unsigned char bam_planes[2][8];      // shown and being built
+static unsigned char *volatile bam_show = bam_planes[0];
+static unsigned char *volatile bam_next;    // built, shown from slot 0
+static unsigned char bam_bit;               // slot being shown
+
+// --------------------------------------------------
+// Patterns
+// A pattern is a table of steps in flash: a brightness for
+// each LED and how many frames (~10 ms each) to hold it.
+// A step with hold 0 ends the table.
+// --------------------------------------------------
+typedef struct {
+    unsigned char level[LED_COUNT];         // RC0..RC7, 0..255
+    unsigned char hold;                     // frames; 0 = end
+} led_step_t;
+
+static const led_step_t *led_pat;           // running pattern, 0 = none
+static const led_step_t *led_pos;           // next step
+static unsigned char led_hold;              // frames left of this step
+static unsigned char led_repeats;           // passes left, 0 = forever
+static volatile unsigned char led_done = 1;
+
+// Transpose eight brightnesses into the spare bit-planes; the
+// interrupt shows them from the next frame's slot 0, so no
+// frame mixes two sets. Called from the interrupt, or with it
+// masked.
+static void ledLoad(const unsigned char *level) {
+    unsigned char *p = (bam_show == bam_planes[0]) ? bam_planes[1] : bam_planes[0];
+    unsigned char i, b, l, m = 0x01;
+
+    for (b = 0; b < 8; b++)
+        p[b] = 0;
+    for (i = 0; i < LED_COUNT; i++) {
+        l = level[i];
+        for (b = 0; b < 8; b++) {
+            if (l & 1)
+                p[b] |= m;
+            l >>= 1;
+        }
+        m <<= 1;
+    }
+    bam_next = p;
+}
+
+// Load the next step, going round again at the end of the
+// table until the passes run out
+static void ledNextStep(void) {
+    if (led_pos->hold == 0) {
+        if (led_repeats && --led_repeats == 0) {
+            led_pat = 0;
+            led_done = 1;
+            return;
+        }
+        led_pos = led_pat;
+    }
+    ledLoad(led_pos->level);
+    led_hold = led_pos->hold;
+    led_pos++;
+}
+
+// --------------------------------------------------
+// FUNCTION: ledISR()
+// Call on INTCONbits.TMR0IF. One port write per slot; the
+// pattern steps in the last, longest slot of the frame, and
+// new bit-planes take over from the next slot 0.
+// --------------------------------------------------
+void ledISR(void) {
+    unsigned int t = BAM_RELOAD[bam_bit];
+
+    INTCONbits.TMR0IF = 0;
+    TMR0H = (unsigned char)(t >> 8);        // buffered until TMR0L is written
+    TMR0L = (unsigned char)t;
+    LATC = bam_show[bam_bit];
+
+    if (bam_bit != 7) {
+        bam_bit++;
+        return;
+    }
+    bam_bit = 0;
+    if (led_pat && --led_hold == 0)
+        ledNextStep();
+    if (bam_next) {
+        bam_show = bam_next;
+        bam_next = 0;
+    }
+}
+
+// --------------------------------------------------
+// FUNCTION: ledPlay(pattern, passes)
+// Plays a pattern table from its first step, 'passes' times
+// (0 = until something else is played). Returns at once.
+// FUNCTION: ledDone()
+// Nonzero once the passes are over; the last step stays lit.
+// --------------------------------------------------
+void ledPlay(const led_step_t *pattern, unsigned char passes) {
+    unsigned char ie = INTCONbits.TMR0IE;
+
+    INTCONbits.TMR0IE = 0;
+    led_pat = pattern;
+    led_pos = pattern;
+    led_repeats = passes;
+    led_done = 0;
+    ledNextStep();
+    INTCONbits.TMR0IE = ie;
+}
+
+unsigned char ledDone(void) {
+    return led_done;
+}
+
+// --------------------------------------------------
+// FUNCTION: ledSetLevels(level[])
+// Stops any pattern and shows the given brightnesses.
+// --------------------------------------------------
+void ledSetLevels(const unsigned char *level) {
+    unsigned char ie = INTCONbits.TMR0IE;
+
+    INTCONbits.TMR0IE = 0;
+    led_pat = 0;
+    led_done = 1;
+    ledLoad(level);
+    INTCONbits.TMR0IE = ie;
+}
+
+// --------------------------------------------------
+// FUNCTION: ledInit()
+// PORTC as outputs, all dark, and the Timer0 engine
+// running. Interrupts must be enabled afterwards (GIE).
+// --------------------------------------------------
+void ledInit(void) {
+    ANSELC = 0x00;
+    TRISC = 0x00;
     LATC = 0x00;
+
+    T0CON = 0x01;         // 16-bit, Fosc/4, 1:4 prescaler = 1 us, stopped
+    TMR0H = (unsigned char)(BAM_RELOAD[0] >> 8);
+    TMR0L = (unsigned char)BAM_RELOAD[0];
+    INTCONbits.TMR0IF = 0;
+    INTCONbits.TMR0IE = 1;
+    T0CONbits.TMR0ON = 1;
+}
+
+// --------------------------------------------------
+// Pattern tables
+// ONLY(n, hold): LED n full on, the rest off.
+// ALL(v, hold): every LED at brightness v.
+// COMET(n, hold) / COMET_BACK(n, hold): LED n full on
+// with a fading tail behind it (n may run past 0..7
+// so the tail can leave the bar).
+// --------------------------------------------------
+#define LVL_ONLY(i, n)  ((i) == (n) ? 255 : 0)
+#define ONLY(n, hold) {{ LVL_ONLY(0, n), LVL_ONLY(1, n), LVL_ONLY(2, n), LVL_ONLY(3, n), \
+                         LVL_ONLY(4, n), LVL_ONLY(5, n), LVL_ONLY(6, n), LVL_ONLY(7, n) }, hold }
+#define ALL(v, hold)  {{ v, v, v, v, v, v, v, v }, hold }
+#define LVL_TAIL(d)     ((d) == 0 ? 255 : (d) == 1 ? 64 : (d) == 2 ? 16 : (d) == 3 ? 4 : 0)
+#define LVL_COMET(i, n) ((i) <= (n) ? LVL_TAIL((n) - (i)) : 0)
+#define LVL_BACK(i, n)  ((i) >= (n) ? LVL_TAIL((i) - (n)) : 0)
+#define COMET(n, hold) {{ LVL_COMET(0, n), LVL_COMET(1, n), LVL_COMET(2, n), LVL_COMET(3, n), \
+                          LVL_COMET(4, n), LVL_COMET(5, n), LVL_COMET(6, n), LVL_COMET(7, n) }, hold }
+#define COMET_BACK(n, hold) {{ LVL_BACK(0, n), LVL_BACK(1, n), LVL_BACK(2, n), LVL_BACK(3, n), \
+                               LVL_BACK(4, n), LVL_BACK(5, n), LVL_BACK(6, n), LVL_BACK(7, n) }, hold }
+#define END {{ 0 }, 0 }
+
+// LED 0 on 500 ms, off 500 ms
+static const led_step_t PAT_BLINK[] = {
+    ONLY(0, 50), ALL(0, 50), END
+};
+
+// All on 200 ms, off 800 ms
+static const led_step_t PAT_BLINK_ALL[] = {
+    ALL(255, 20), ALL(0, 80), END
+};
+
+// Back and forth at 120 ms per LED, 500 ms at each end
+static const led_step_t PAT_SWEEP[] = {
+    ONLY(0, 62), ONLY(1, 12), ONLY(2, 12), ONLY(3, 12),
+    ONLY(4, 12), ONLY(5, 12), ONLY(6, 12), ONLY(7, 62),
+    ONLY(6, 12), ONLY(5, 12), ONLY(4, 12), ONLY(3, 12),
+    ONLY(2, 12), ONLY(1, 12), END
+};
+
+// The original main loop: forward at 200 ms per LED, pause,
+// blink all, backward, pause, blink all
+static const led_step_t PAT_SWEEP_BLINK[] = {
+    ONLY(0, 20), ONLY(1, 20), ONLY(2, 20), ONLY(3, 20),
+    ONLY(4, 20), ONLY(5, 20), ONLY(6, 20), ONLY(7, 70),
+    ALL(255, 20), ALL(0, 80),
+    ONLY(7, 20), ONLY(6, 20), ONLY(5, 20), ONLY(4, 20),
+    ONLY(3, 20), ONLY(2, 20), ONLY(1, 20), ONLY(0, 70),
+    ALL(255, 20), ALL(0, 80), END
+};
+
+// Forward only at 20 ms per LED
+static const led_step_t PAT_FAST[] = {
+    ONLY(0, 2), ONLY(1, 2), ONLY(2, 2), ONLY(3, 2),
+    ONLY(4, 2), ONLY(5, 2), ONLY(6, 2), ONLY(7, 2), END
+};
+
+// A comet with a three-LED tail, out and back
+static const led_step_t PAT_COMET[] = {
+    COMET(0, 6), COMET(1, 6), COMET(2, 6), COMET(3, 6),
+    COMET(4, 6), COMET(5, 6), COMET(6, 6), COMET(7, 6),
+    COMET(8, 6), COMET(9, 6), COMET(10, 6),
+    COMET_BACK(7, 6), COMET_BACK(6, 6), COMET_BACK(5, 6), COMET_BACK(4, 6),
+    COMET_BACK(3, 6), COMET_BACK(2, 6), COMET_BACK(1, 6), COMET_BACK(0, 6),
+    COMET_BACK(-1, 6), COMET_BACK(-2, 6), COMET_BACK(-3, 6), END
+};
+
+// All LEDs fading up and down, in steps that look even to the eye
+static const led_step_t PAT_BREATHE[] = {
+    ALL(0, 8), ALL(2, 4), ALL(6, 4), ALL(14, 4), ALL(28, 4), ALL(50, 4),
+    ALL(80, 4), ALL(120, 4), ALL(170, 4), ALL(230, 4), ALL(255, 12),
+    ALL(230, 4), ALL(170, 4), ALL(120, 4), ALL(80, 4), ALL(50, 4),
+    ALL(28, 4), ALL(14, 4), ALL(6, 4), ALL(2, 4), END
+};
+
+// --------------------------------------------------
+// Effects
+// Each starts its pattern and returns at once.
+// --------------------------------------------------
+void CLEARLED() {
+    static const unsigned char off[LED_COUNT] = { 0 };
+    ledSetLevels(off);
 }
 
 void SET_LED(unsigned char pin) {
-    LATC = (1 << pin);
+    unsigned char level[LED_COUNT] = { 0 };
+    if (pin < LED_COUNT)
+        level[pin] = 255;
+    ledSetLevels(level);
 }
 
 void Blink() {
-    TRISC = 0x00;
-    while (1) {
-        LATC = 0x01;
-        __delay_ms(500);
-        LATC = 0x00;
-        __delay_ms(500);
-    }
+    ledPlay(PAT_BLINK, 0);
 }
 
 void BlinkALL() {
-    const unsigned int ON_MS = 200;
-    const unsigned int OFF_MS = 800;
-    TRISC = 0x00;
-    LATC = 0xFF;
-    __delay_ms(ON_MS);
-    LATC = 0x00;
-    __delay_ms(OFF_MS);
+    ledPlay(PAT_BLINK_ALL, 1);
 }
 
 void Sweep() {
-    signed char i;
-    TRISC = 0x00;
-    LATC = 0x00;
-    while (1) {
-        __delay_ms(500);
-        for (i = 0; i <= 7; i++) {
-            LATC = (1 << i);
-            __delay_ms(120);
-        }
-        __delay_ms(500);
-        for (i = 6; i >= 0; i--) {
-            LATC = (1 << i);
-            __delay_ms(120);
-        }
-    }
+    ledPlay(PAT_SWEEP, 0);
 }
 
-void sweep_forward() {
-    unsigned char i;
-    for (i = 0; i < 8; i++) {
-        SET_LED(i);
-        __delay_ms(200);
-    }
+void SweepSpeedControl() {
+    ledPlay(PAT_FAST, 0);
 }
 
-void sweep_backward() {
-    signed char i;
-    for (i = 7; i >= 0; i--) {
-        SET_LED(i);
-        __delay_ms(200);
-    }
+void Comet() {
+    ledPlay(PAT_COMET, 0);
 }
 
-void pause_at_end() {
-    __delay_ms(500);
+void Breathe() {
+    ledPlay(PAT_BREATHE, 0);
 }
 
-void SweepSpeedControl() {
-    const int SPEED_MS = 20;
-    unsigned char i;
-    TRISC = 0x00;
-    while (1) {
-        for (i = 0; i < 8; i++) {
-            LATC = (1 << i);
-            __delay_ms(SPEED_MS);
-        }
-    }
+// --------------------------------------------------
+// INTERRUPTS
+// --------------------------------------------------
+#ifndef LAB_LIBRARY   // the benchmarks link this file without its vector
+HAL_ISR(isr) {
+    if (INTCONbits.TMR0IF)
+        ledISR();
 }
+#endif
 
+// --------------------------------------------------
+// MAIN PROGRAM
+// The original sweep-and-blink sequence twice, then a
+// comet and a breathing fade, over and over. The loop
+// only picks the next pattern when one is over.
+// --------------------------------------------------
 void main() {
-    TRISC = 0x00;
-    CLEARLED();
+    static const led_step_t *const show[] = { PAT_SWEEP_BLINK, PAT_COMET, PAT_BREATHE };
+    static const unsigned char passes[] = { 2, 4, 3 };
+    unsigned char next = 0;
+
+    ledInit();
+    INTCONbits.GIE = 1;
+
     while (1) {
-        sweep_forward();
-        pause_at_end();
-        BlinkALL();
-        sweep_backward();
-        pause_at_end();
-        BlinkALL();
+        if (ledDone()) {
+            ledPlay(show[next], passes[next]);
+            if (++next == sizeof(passes))
+                next = 0;
+        }
+        HAL_IDLE();
     }
 }
@@ -1,4 +1,7 @@
-#include <xc.h>
+#include "hal.h"
+#include "debounce.h"
+#include "power.h"
+#include "sched.h"
 #define _XTAL_FREQ 16000000UL
 
 // -----------------------------------------
@@ -8,32 +11,77 @@
 #define BUTTON_DEC PORTBbits.RB1
 #define LED_PORT   LATC
 
+// Tasks 1B and 2 run on the Timer6 scheduler
+// (sched.h): a short task polls the buttons and
+// the tick's millisecond count stands in for the
+// delays, so the loop never waits.
+#define POLL_MS     10    // Task 1B button poll
+#define BLINK_MS    200   // Task 1B half period
+#define LOCKOUT_MS  80    // Task 2 basic debounce
+
 
 // -----------------------------------------
 // Task 1B – Blink RC0 while RB0 is held down
 // -----------------------------------------
+static unsigned int blink_at;   // Next toggle, Sched_Millis()
+
+static void blinkPoll(void) {
+    unsigned int now = Sched_Millis();
+
+    if (PORTBbits.RB0 != 0) {           // Released
+        LATCbits.LATC0 = 0;            // LED OFF when button released
+        blink_at = now;                // On again as soon as pressed
+        return;
+    }
+    if ((int)(now - blink_at) >= 0) {
+        LATCbits.LATC0 ^= 1;           // ON, then OFF, every BLINK_MS
+        blink_at += BLINK_MS;
+    }
+}
+
 void task1B_blinkWhileHeld(void) {
     ANSELB = 0;      // PORTB digital
     ANSELC = 0;      // PORTC digital
     TRISBbits.TRISB0 = 1; // RB0 = button input
     TRISCbits.TRISC0 = 0; // RC0 = LED output
+    LATCbits.LATC0 = 0;
 
-    while (1) {
-        if (PORTBbits.RB0 == 0) {       // Button pressed
-            LATCbits.LATC0 = 1;        // LED ON
-            __delay_ms(200);
-            LATCbits.LATC0 = 0;        // LED OFF
-            __delay_ms(200);
-        } else {
-            LATCbits.LATC0 = 0;        // LED OFF when button released
-        }
-    }
+    Sched_Init();
+    Sched_Every(Sched_Task(blinkPoll), POLL_MS);
+    INTCONbits.GIE = 1;
+    Sched_Run();
 }
 
 
 // -----------------------------------------
 // Task 2 – Two-button counter (increment & decrement)
+// Polled every tick; after a press both buttons
+// are ignored for LOCKOUT_MS.
 // -----------------------------------------
+static unsigned char counter2;
+static unsigned char prev2 = 0x03;     // previous RB1:RB0 state
+static unsigned int press_at;
+
+static void counterPoll(void) {
+    unsigned int now = Sched_Millis();
+    unsigned char cur, fall;
+
+    if ((unsigned int)(now - press_at) < LOCKOUT_MS)
+        return;                        // Basic debounce
+    cur = PORTB & 0x03;
+    fall = prev2 & (unsigned char)~cur;
+    prev2 = cur;
+
+    if (fall & 0x01)                   // Falling edge RB0
+        counter2++;
+    if (fall & 0x02)                   // Falling edge RB1
+        counter2--;
+    if (fall) {
+        LED_PORT = counter2;
+        press_at = now;
+    }
+}
+
 void task2_counterTwoButtons(void) {
     ANSELB = 0;
     ANSELC = 0;
@@ -42,52 +90,34 @@ void task2_counterTwoButtons(void) {
     TRISBbits.TRISB1 = 1; // RB1 = decrement button
     TRISC = 0x00;         // PORTC = LED bar output
 
-    unsigned char counter = 0;
-    unsigned char prev_inc = 1; // previous RB0 state
-    unsigned char prev_dec = 1; // previous RB1 state
-
-    LED_PORT = counter;
-
-    while (1) {
-        unsigned char cur_inc = PORTBbits.RB0;
-        unsigned char cur_dec = PORTBbits.RB1;
-
-        if (prev_inc == 1 && cur_inc == 0) {   // Falling edge RB0
-            counter++;
-            LED_PORT = counter;
-            __delay_ms(80);                   // Basic debounce
-        }
-
-        if (prev_dec == 1 && cur_dec == 0) {   // Falling edge RB1
-            counter--;
-            LED_PORT = counter;
-            __delay_ms(80);
-        }
+    counter2 = 0;
+    LED_PORT = counter2;
 
-        prev_inc = cur_inc;
-        prev_dec = cur_dec;
-    }
+    Sched_Init();
+    press_at = Sched_Millis() - LOCKOUT_MS;
+    Sched_Every(Sched_Task(counterPoll), 1);
+    INTCONbits.GIE = 1;
+    Sched_Run();
 }
 
 
 // -----------------------------------------
-// Task 3A – Debounced falling-edge detect on RB0
-// Returns 1 once per *clean* press
+// Task 3 – Debounced buttons
+// The Timer6 tick in debounce.c samples all of
+// PORTB and latches each clean press, so the
+// loops below never wait on a button.
 // -----------------------------------------
-unsigned char pressed_falling_debounced(void) {
-    static unsigned char prev = 1;        // previous button state
-    unsigned char cur = PORTBbits.RB0;    // current button level
-
-    if (prev == 1 && cur == 0) {          // Possible falling edge
-        __delay_ms(30);                   // Debounce delay
-        if (PORTBbits.RB0 == 0) {         // Still low → valid press
-            prev = 0;
-            return 1;
-        }
+#define BTN_RB0 0x01
+#define BTN_RB1 0x02
+
+HAL_ISR(isr) {
+    if (PIR5bits.TMR6IF) {
+        if (Sched_Active())           // Tasks 1B and 2
+            Sched_ISR_Handler();
+        else
+            Debounce_ISR_Handler();
     }
-
-    prev = cur;
-    return 0;
+    Power_ISR_Handler();              // INT0/INT1 wake-ups
 }
 
 
@@ -102,9 +132,11 @@ void task3A_toggleWithDebounce(void) {
     TRISCbits.TRISC0 = 0; // LED output
 
     LATCbits.LATC0 = 0;
+    Debounce_Init(BTN_RB0);
+    INTCONbits.GIE = 1;
 
     while (1) {
-        if (pressed_falling_debounced()) { 
+        if (Debounce_Pressed(BTN_RB0)) {
             LATCbits.LATC0 ^= 1;          // Toggle LED
         }
     }
@@ -113,30 +145,9 @@ void task3A_toggleWithDebounce(void) {
 
 // -----------------------------------------
 // Task 3B – Debounced increment and decrement
+// Sleeps between presses: INT0/INT1 wake the
+// core and the press is counted at once.
 // -----------------------------------------
-static unsigned char prev0 = 1;
-static unsigned char prev1 = 1;
-
-unsigned char debounced_falling_RB0(void) {
-    unsigned char cur = PORTBbits.RB0;
-    if (prev0 == 1 && cur == 0) {         // RB0 falling edge
-        __delay_ms(30);                   // debounce
-        if (PORTBbits.RB0 == 0) { prev0 = 0; return 1; }
-    }
-    prev0 = cur;
-    return 0;
-}
-
-unsigned char debounced_falling_RB1(void) {
-    unsigned char cur = PORTBbits.RB1;
-    if (prev1 == 1 && cur == 0) {         // RB1 falling edge
-        __delay_ms(30);
-        if (PORTBbits.RB1 == 0) { prev1 = 0; return 1; }
-    }
-    prev1 = cur;
-    return 0;
-}
-
 void task3B_counterDebounced(void) {
     ANSELB = 0;
     ANSELC = 0;
@@ -147,17 +158,21 @@ void task3B_counterDebounced(void) {
 
     unsigned char counter = 0;
     LED_PORT = counter;
+    Debounce_Init(BTN_RB0 | BTN_RB1);
+    Power_Init(BTN_RB0 | BTN_RB1);
+    INTCONbits.GIE = 1;
 
     while (1) {
-        if (debounced_falling_RB0()) {    // Clean increment
+        if (Debounce_Pressed(BTN_RB0)) {  // Clean increment
             counter++;
             LED_PORT = counter;
         }
 
-        if (debounced_falling_RB1()) {    // Clean decrement
+        if (Debounce_Pressed(BTN_RB1)) {  // Clean decrement
             counter--;
             LED_PORT = counter;
         }
+        Power_Sleep(0);                   // LEDs hold in Sleep
     }
 }
 
@@ -1,4 +1,6 @@
-#include <xc.h>
+#include "hal.h"
+#include "debounce.h"
+#include "sched.h"
 #define _XTAL_FREQ 16000000
 
 // 7-segment patterns (common cathode)
@@ -17,10 +19,152 @@ const unsigned char SEGMENT_TABLE[10] = {
 
 #define MAX_DIGITS 4  // max digits on board
 
+// Refresh engine settings
+#define REFRESH_HZ 100    // default full-display refreshes per second
+#define BRIGHT_MAX 16     // brightness levels 0 (off) .. BRIGHT_MAX (full)
+
+// --------------------------------------------------
+// Interrupt-driven refresh
+// Timer0 (1 us per count) splits each frame into one slot per
+// digit. A digit is lit for the first part of its slot and blanked
+// for the rest, so its brightness is its on-time duty cycle.
+// The ISR only reads precomputed on-times; the main loop does
+// nothing for the display beyond changing the buffers.
+// --------------------------------------------------
+volatile unsigned char disp_seg[MAX_DIGITS];       // segment patterns
+static unsigned char disp_bright[MAX_DIGITS];      // 0..BRIGHT_MAX
+static volatile unsigned int disp_on_us[MAX_DIGITS];
+static volatile unsigned int disp_slot_us;
+static unsigned char disp_pos;                     // digit being shown
+static unsigned char disp_lit;                     // in the on-part of a slot
+
+// Reload Timer0 so it overflows after 'us' microseconds
+static void displayArm(unsigned int us) {
+    unsigned int t = (unsigned int)(0u - us);
+    TMR0H = (unsigned char)(t >> 8);   // buffered until TMR0L is written
+    TMR0L = (unsigned char)t;
+}
+
+// Recompute each digit's on-time from its brightness. TMR0IE is put
+// back as it was, so this does not start a display not yet started.
+static void displayUpdateOnTimes(void) {
+    for (unsigned char i = 0; i < MAX_DIGITS; i++) {
+        unsigned int on = (unsigned int)(((unsigned long)disp_slot_us * disp_bright[i]) / BRIGHT_MAX);
+        unsigned char ie = INTCONbits.TMR0IE;
+        INTCONbits.TMR0IE = 0;         // 16-bit value read by the ISR
+        disp_on_us[i] = on;
+        INTCONbits.TMR0IE = ie;
+    }
+}
+
+// --------------------------------------------------
+// FUNCTION: displaySetRefreshHz(hz)
+// Full-display refresh rate; 60..1000 Hz is sensible.
+// --------------------------------------------------
+void displaySetRefreshHz(unsigned int hz) {
+    if (hz == 0) return;
+    unsigned int slot = (unsigned int)(1000000UL / ((unsigned long)hz * MAX_DIGITS));
+    unsigned char ie = INTCONbits.TMR0IE;
+    INTCONbits.TMR0IE = 0;
+    disp_slot_us = slot;
+    INTCONbits.TMR0IE = ie;
+    displayUpdateOnTimes();
+}
+
+// --------------------------------------------------
+// FUNCTION: displaySetBrightness(pos, level)
+// Brightness 0..BRIGHT_MAX of one digit (0 = leftmost).
+// FUNCTION: displaySetAllBrightness(level)
+// Same for every digit.
+// --------------------------------------------------
+void displaySetBrightness(unsigned char pos, unsigned char level) {
+    if (pos >= MAX_DIGITS) return;
+    disp_bright[pos] = (level > BRIGHT_MAX) ? BRIGHT_MAX : level;
+    displayUpdateOnTimes();
+}
+
+void displaySetAllBrightness(unsigned char level) {
+    if (level > BRIGHT_MAX) level = BRIGHT_MAX;
+    for (unsigned char i = 0; i < MAX_DIGITS; i++)
+        disp_bright[i] = level;
+    displayUpdateOnTimes();
+}
+
+// --------------------------------------------------
+// FUNCTION: displayISR()
+// Call on INTCONbits.TMR0IF. Two interrupts per digit:
+// one to light it, one to blank it when its on-time is up
+// (skipped at 0 or full brightness).
+// --------------------------------------------------
+void displayISR(void) {
+    INTCONbits.TMR0IF = 0;
+
+    if (disp_lit) {                    // on-time over: dark for the rest
+        LATA = 0x00;
+        disp_lit = 0;
+        displayArm(disp_slot_us - disp_on_us[disp_pos]);
+        return;
+    }
+
+    disp_pos = (disp_pos + 1) & (MAX_DIGITS - 1);
+    unsigned int on = disp_on_us[disp_pos];
+
+    LATA = 0x00;                       // blank before switching segments
+    LATC = disp_seg[disp_pos];
+    if (on == 0) {
+        displayArm(disp_slot_us);
+        return;
+    }
+    LATA = (unsigned char)(1 << disp_pos);
+    if (on < disp_slot_us) {
+        disp_lit = 1;
+        displayArm(on);
+    } else {
+        displayArm(disp_slot_us);
+    }
+}
+
+// --------------------------------------------------
+// FUNCTION: clearDigits()
+// Blanks all digits in the display buffer.
+// --------------------------------------------------
+void clearDigits() {
+    for (unsigned char i = 0; i < MAX_DIGITS; i++)
+        disp_seg[i] = 0x00;
+}
+
+// --------------------------------------------------
+// Scheduler
+// Timer6 runs the scheduler (sched.h) from
+// init7seg on: a task samples the buttons, and
+// showDigitFor and cycleDigitsBetween time the
+// display from it instead of waiting.
+// --------------------------------------------------
+static unsigned char task_blank = SCHED_NONE;
+static unsigned char timer_blank = SCHED_NONE;
+static unsigned int blank_at;          // Sched_Millis() to blank at
+
+static void buttonsTask(void) {
+    Debounce_Tick();
+}
+
+// One-shot: blanks the digit unless a newer
+// showDigitFor moved the deadline on
+static void blankTask(void) {
+    timer_blank = SCHED_NONE;
+    if ((int)(Sched_Millis() - blank_at) >= 0)
+        clearDigits();
+}
+
 // --------------------------------------------------
 // FUNCTION: init7seg()
 // Sets up PORTA (digit select), PORTC (segments),
-// and RB0/RB1 as input buttons.
+// and RB0/RB1 as input buttons, then starts the
+// Timer0 refresh at REFRESH_HZ and full brightness
+// and the Timer6 scheduler, which samples the
+// buttons. Interrupts must be enabled afterwards
+// (GIE), and the main loop must keep the tasks
+// running (Sched_Run_Once).
 // --------------------------------------------------
 void init7seg() {
     ANSELA = 0x00;
@@ -35,108 +179,151 @@ void init7seg() {
 
     PORTA = 0x00;
     PORTC = 0x00;
-}
 
-// --------------------------------------------------
-// FUNCTION: clearDigits()
-// Turns off all digits and clears segments.
-// --------------------------------------------------
-void clearDigits() {
-    PORTA = 0x00;
-    PORTC = 0x00;
+    for (unsigned char i = 0; i < MAX_DIGITS; i++) {
+        disp_seg[i] = 0x00;
+        disp_bright[i] = BRIGHT_MAX;
+    }
+    disp_slot_us = (unsigned int)(1000000UL / ((unsigned long)REFRESH_HZ * MAX_DIGITS));
+    for (unsigned char i = 0; i < MAX_DIGITS; i++)
+        disp_on_us[i] = disp_slot_us;
+
+    T0CON = 0x01;         // 16-bit, Fosc/4, 1:4 prescaler = 1 us, stopped
+    displayArm(disp_slot_us);
+    INTCONbits.TMR0IF = 0;
+    INTCONbits.TMR0IE = 1;
+    T0CONbits.TMR0ON = 1;
+
+    Debounce_Init_Polled(0x03);       // RB0, RB1, sampled by buttonsTask
+    Sched_Init();
+    Sched_Every(Sched_Task(buttonsTask), DEBOUNCE_TICK_MS);
+    task_blank = Sched_Task(blankTask);
 }
 
 // --------------------------------------------------
 // FUNCTION: showDigitFor(digit, ms)
-// Shows a single digit for the given number of ms.
+// Shows a single digit on digit 1 and returns;
+// a scheduler timer blanks it after the given
+// number of ms (0: stays on). The timer only
+// fires while Sched_Run (or Sched_Run_Once) runs
+// the tasks.
 // --------------------------------------------------
 void showDigitFor(unsigned char digit, unsigned int ms) {
     if (digit > 9) return;
 
-    PORTC = SEGMENT_TABLE[digit];
-    PORTA = 0x01;        // enable digit 1 (adjust if needed)
-
-    while (ms--) __delay_ms(1);
+    Sched_Cancel(timer_blank);
+    timer_blank = SCHED_NONE;
 
     clearDigits();
+    disp_seg[0] = SEGMENT_TABLE[digit];
+
+    if (ms) {
+        blank_at = Sched_Millis() + ms;
+        timer_blank = Sched_After(task_blank, ms);
+    }
 }
 
 // --------------------------------------------------
-// FUNCTION: showDigits(digits[], count, ms)
-// Displays multiple digits for a short refresh time.
-// Refuses if count > MAX_DIGITS.
+// FUNCTION: showDigits(digits[], count)
+// Loads up to MAX_DIGITS digits into the display,
+// leftmost first. Refuses if count > MAX_DIGITS;
+// invalid digits (> 9) are left blank.
 // --------------------------------------------------
-void showDigits(unsigned char digits[], unsigned char count, unsigned int ms) {
+void showDigits(unsigned char digits[], unsigned char count) {
     if (count > MAX_DIGITS) return; // refuse if too many digits
 
-    for (unsigned char i = 0; i < count; i++) {
-        if (digits[i] > 9) continue;   // skip invalid digits
-        PORTC = SEGMENT_TABLE[digits[i]];
-        PORTA = (1 << i);              // enable current digit
-        __delay_ms(ms);
-        clearDigits();
+    for (unsigned char i = 0; i < MAX_DIGITS; i++) {
+        if (i < count && digits[i] <= 9)
+            disp_seg[i] = SEGMENT_TABLE[digits[i]];
+        else
+            disp_seg[i] = 0x00;
     }
 }
 
 // --------------------------------------------------
 // FUNCTION: cycleDigitsBetween(start, end, delay_ms)
-// Cycles continuously from start → end → start.
+// Cycles continuously from start → end → start,
+// one digit every delay_ms from a periodic task.
+// Runs the scheduler from then on; never returns.
 // --------------------------------------------------
+static unsigned char cycle_start, cycle_end, cycle_d;
+static unsigned int cycle_ms;
+
+static void cycleTask(void) {
+    showDigitFor(cycle_d, cycle_ms);
+    cycle_d++;
+    if (cycle_d > cycle_end) cycle_d = cycle_start;
+}
+
 void cycleDigitsBetween(unsigned char start,
     unsigned char end,
     unsigned int delay_ms)
 {
-    if (start > 9 || end > 9) return;
+    if (start > 9 || end > 9 || delay_ms == 0) return;
 
-    unsigned char d = start;
+    cycle_start = start;
+    cycle_end = end;
+    cycle_d = start;
+    cycle_ms = delay_ms;
 
-    while (1) {
-        showDigitFor(d, delay_ms);
-        d++;
-        if (d > end) d = start;
-    }
+    cycleTask();                       // First digit now
+    Sched_Every(Sched_Task(cycleTask), delay_ms);
+    Sched_Run();
 }
 
 // --------------------------------------------------
 // FUNCTION: incrementDigitOnRB0(current)
-// Returns current+1 when RB0 is pressed.
+// Returns current+1 once per debounced RB0 press.
+// Never waits: the press was latched by the
+// buttons task.
 // --------------------------------------------------
 unsigned char incrementDigitOnRB0(unsigned char current) {
-    if (!PORTBbits.RB0) {       // button pressed (active low)
-        __delay_ms(20);         // debounce
-        while (!PORTBbits.RB0); // wait for release
+    if (Debounce_Pressed(0x01))
         current = (current + 1) % 10;
-    }
     return current;
 }
 
 // --------------------------------------------------
 // FUNCTION: decrementDigitOnRB1(current)
-// Returns current-1 when RB1 is pressed.
+// Returns current-1 once per debounced RB1 press.
 // --------------------------------------------------
 unsigned char decrementDigitOnRB1(unsigned char current) {
-    if (!PORTBbits.RB1) {       // button pressed
-        __delay_ms(20);
-        while (!PORTBbits.RB1);
+    if (Debounce_Pressed(0x02))
         current = (current == 0) ? 9 : current - 1;
-    }
     return current;
 }
 
+// --------------------------------------------------
+// INTERRUPTS
+// --------------------------------------------------
+HAL_ISR(isr) {
+    if (INTCONbits.TMR0IF)
+        displayISR();
+    if (PIR5bits.TMR6IF)
+        Sched_ISR_Handler();
+}
+
 // --------------------------------------------------
 // MAIN PROGRAM
-// Displays a digit and allows increment/decrement.
+// Shows the button-controlled digit on digit 1 and
+// 2, 3, 4 beside it, each dimmer than the last.
 // --------------------------------------------------
 void main() {
     init7seg();
+    INTCONbits.GIE = 1;
 
     unsigned char digit = 0;
-    unsigned char digits[4] = { 1, 2, 3, 4 }; // example multi-digit display
+    unsigned char digits[4] = { 0, 2, 3, 4 }; // example multi-digit display
+
+    displaySetBrightness(1, BRIGHT_MAX * 3 / 4);
+    displaySetBrightness(2, BRIGHT_MAX / 2);
+    displaySetBrightness(3, BRIGHT_MAX / 4);
 
     while (1) {
         digit = incrementDigitOnRB0(digit);
         digit = decrementDigitOnRB1(digit);
-        showDigitFor(digit, 5);          // single digit refresh
-        showDigits(digits, 4, 5);        // multi-digit refresh
+        digits[0] = digit;
+        showDigits(digits, 4);
+        Sched_Run_Once();
     }
 }
@@ -2,13 +2,16 @@
 // PIC18(L)F2X/4XK22 - LM35 temperature display on 4-digit 7-segment
 // RD0=a .. RD7=dp, RA0..RA3 digit enables, common-cathode
 
-#include <xc.h>
+#include "hal.h"
+#include "bcd.h"
+#include "calib.h"
+#include "filter.h"
 
 #define SCAN_ON_US 900
 #define BLANK_US 80
-#define SAMPLE_FRAMES 250
-#define MA_N 8
-#define VREF_mV 5000u  // Change to 3300u if J5 = 3.3 V
+#define SAMPLE_MS 250     // ADC sample period, multiple of 10 ms
+#define T_FILTER FILTER_BOXCAR   // FILTER_BOXCAR, _IIR, _MEDIAN or _HYST (filter.h)
+#define T_FILTER_PARAM 3         // boxcar of 2^3 = 8 samples
 
 // Lookup table for common-cathode 7-segment
 unsigned char seg_for(unsigned char d){
@@ -24,12 +27,11 @@ void all_off(void){ LATA = 0x00; }
 // Enable a specific digit (0..3)
 void enable_pos(unsigned char pos){ LATA = (unsigned char)(1u << pos); }
 
-// Split integer 0..9999 into four decimal digits
+// Split integer 0..9999 into four decimal digits (no division)
 void split4(unsigned int v, unsigned char *u, unsigned char *t, unsigned char *h, unsigned char *th){
-    *u = v % 10u;
-    *t = (v / 10u) % 10u;
-    *h = (v / 100u) % 10u;
-    *th = (v / 1000u) % 10u;
+    unsigned char d[4];
+    bin_to_bcd4(v, d);
+    *th = d[0]; *h = d[1]; *t = d[2]; *u = d[3];
 }
 
 // Initialize ADC for LM35 (AN6 = RE1)
@@ -38,24 +40,25 @@ void ADC_Init(void){
     TRISE1_bit = 1;   // input
     ADCON1 = 0x00;    // Vref+ = VDD, Vref- = VSS
     ADCON2 = 0xA9;    // right-justified, safe acquisition
+    ADCON0bits.ADON = 1;  // stays on; GO alone starts a sample
 }
 
 // Sample ADC channel 0..15, return 10-bit result
+// ACQT gives the hold capacitor its acquisition time after GO,
+// so no software delay is needed, even after a channel change.
 unsigned int ADC_Get_Sample(unsigned char ch){
-    ADCON0 = (unsigned char)(ch << 2); // select channel
-    ADCON0.F0 = 1;                     // ADON
-    Delay_ms(2);
-    ADCON0.F1 = 1;                     // GO/DONE
-    while(ADCON0.F1);
+    ADCON0 = (unsigned char)((ch << 2) | 0x01); // select channel, keep ADON
+    ADCON0bits.GO = 1;                 // GO/DONE
+    while(ADCON0bits.GO);
     return (unsigned int)((((unsigned int)ADRESH) << 8) | ADRESL);
 }
 
-// Convert raw ADC to temperature in 0.01°C (T100), integer math
+// Convert raw ADC to temperature in 0.01°C (T100)
+// Calibration table lookup; VREF_mV is a build option (calib.h)
 unsigned int adc_to_T100(unsigned int adc){
-    unsigned long t = (unsigned long)adc * (unsigned long)VREF_mV * 10ul; // adc*mV*10
-    t = (t + 511ul) / 1023ul; // rounding
-    if(t > 9999ul) t = 9999ul; // clamp to display
-    return (unsigned int)t;
+    unsigned int t = cal_T100(adc, 0);
+    if(t > 9999u) t = 9999u; // clamp to display
+    return t;
 }
 
 // Initialize 7-segment display ports
@@ -67,54 +70,127 @@ void init7seg(void){
     LATD = 0; all_off();
 }
 
+// ---------------- Interrupt-driven display ----------------
+// Timer2 (Fosc/4 1:16 = 4 us per count) times each digit: SCAN_ON_US
+// lit, then 2*BLANK_US dark before the next one, as the old Delay_us
+// scan did. displayTemperature() prepares the segment patterns in the
+// back frame; the ISR swaps frames at digit 0 so a scan never mixes
+// two readings.
+#define T2_ON_PR    (SCAN_ON_US / 4u - 1u)
+#define T2_BLANK_PR (2u * BLANK_US / 4u - 1u)
+
+static volatile unsigned char seg_frame[2][4]; // [frame][pos], pos 0 = units
+static volatile unsigned char seg_front = 0, seg_swap = 0;
+static unsigned char scan_pos = 3, scan_lit = 0;
+
+// Timer2 match: light the next digit or blank the current one
+void scan_isr(void){
+    PIR1bits.TMR2IF = 0;
+    if(scan_lit){
+        all_off(); LATD = 0;
+        PR2 = T2_BLANK_PR;
+        scan_lit = 0;
+        return;
+    }
+    if(++scan_pos >= 4u) scan_pos = 0u;
+    if(scan_pos == 0u && seg_swap){ seg_front ^= 1u; seg_swap = 0; }
+    LATD = seg_frame[seg_front][scan_pos];
+    enable_pos(scan_pos);
+    PR2 = T2_ON_PR;
+    scan_lit = 1;
+}
+
 // Display temperature on 4-digit 7-segment with decimal (XX.XX °C)
+// Only prepares the patterns; the Timer2 interrupt shows them.
 void displayTemperature(unsigned int T100){
-    static unsigned char pos = 0;
     unsigned char u,t,h,th;
 
     split4(T100, &u, &t, &h, &th);
 
-    // Multiplexed display
-    all_off(); LATD = 0; Delay_us(BLANK_US);
-    if(pos == 0u) LATD = seg_for(u);                // units of 0.01°C
-    else if(pos == 1u) LATD = (unsigned char)(seg_for(t) | 0x80u); // tens with decimal
-    else if(pos == 2u) LATD = seg_for(h);
-    else LATD = (th == 0u ? 0x00 : seg_for(th));   // optional leading zero blank
-    enable_pos(pos); Delay_us(SCAN_ON_US);
-    all_off(); LATD = 0; Delay_us(BLANK_US);
+    seg_swap = 0;                   // withdraw a frame the ISR has not taken
+    volatile unsigned char *back = seg_frame[seg_front ^ 1u];
+    back[0] = seg_for(u);                          // units of 0.01°C
+    back[1] = (unsigned char)(seg_for(t) | 0x80u); // tens with decimal
+    back[2] = seg_for(h);
+    back[3] = (th == 0u ? 0x00 : seg_for(th));     // optional leading zero blank
+    seg_swap = 1;
+}
+
+// ---------------- Fixed-period sampling ----------------
+// Timer6 (1:16, PR6 = 249, 1:10 postscaler) ticks every 10 ms from the
+// crystal, independent of what the foreground is doing. Every
+// SAMPLE_MS it starts a conversion on the channel left selected by
+// ADC_Get_Sample(); the ADC interrupt hands the result over.
+#define SAMPLE_TICKS (SAMPLE_MS / 10u)
+
+static unsigned char sample_ticks = 0;
+static volatile unsigned int adc_result;
+static volatile unsigned char adc_ready = 0;
+
+void sample_isr(void){
+    PIR5bits.TMR6IF = 0;
+    if(++sample_ticks >= SAMPLE_TICKS){
+        sample_ticks = 0;
+        ADCON0bits.GO = 1;          // acquisition time from ADCON2.ACQT
+    }
+}
 
-    pos++; if(pos >= 4u) pos = 0u;
+void adc_isr(void){
+    PIR1bits.ADIF = 0;
+    adc_result = (unsigned int)((((unsigned int)ADRESH) << 8) | ADRESL);
+    adc_ready = 1;
 }
 
-// Main temperature loop with moving-average smoothing
+// Start the display scan and the sample timer
+void timers_init(void){
+    T2CON = 0x00; T2CONbits.T2CKPS = 2;             // 1:16 -> 4 us
+    TMR2 = 0; PR2 = T2_BLANK_PR;
+    T6CON = 0x00; T6CONbits.T6CKPS = 2; T6CONbits.T6OUTPS = 9; // 1 ms x 10
+    TMR6 = 0; PR6 = 249;
+
+    PIR1bits.TMR2IF = 0; PIR5bits.TMR6IF = 0; PIR1bits.ADIF = 0;
+    PIE1bits.TMR2IE = 1; PIE5bits.TMR6IE = 1; PIE1bits.ADIE = 1;
+    INTCONbits.PEIE = 1;
+    T2CONbits.TMR2ON = 1; T6CONbits.TMR6ON = 1;
+    INTCONbits.GIE = 1;
+}
+
+#ifndef LAB_LIBRARY   // the benchmarks link this file without its vector
+HAL_ISR(isr){
+    if(PIR1bits.TMR2IF) scan_isr();
+    if(PIR5bits.TMR6IF) sample_isr();
+    if(PIR1bits.ADIF) adc_isr();
+}
+#endif
+
+// Main temperature loop, smoothed by the T_FILTER filter
 void temperatureLoop(void){
-    unsigned int T100, T100_avg, buf[MA_N];
-    unsigned long sum = 0;
-    unsigned char idx = 0, i = 0, frame = 0;
+    filter_t smooth;
 
     init7seg();
     ADC_Init();
 
-    // Seed moving average
-    for(i=0; i<MA_N; i++){
-        buf[i] = adc_to_T100(ADC_Get_Sample(6));
-        sum += buf[i];
-    }
-    T100_avg = (unsigned int)(sum / MA_N);
+    // Seed the filter (leaves AN6 selected for the sample timer)
+    filter_init(&smooth, T_FILTER, T_FILTER_PARAM);
+    filter_push(&smooth, adc_to_T100(ADC_Get_Sample(6)));
+    displayTemperature(filter_value(&smooth));
+    timers_init();
 
     while(1){
-        // Take new sample every SAMPLE_FRAMES display frames
-        if(++frame >= SAMPLE_FRAMES){
-            frame = 0;
-            sum -= buf[idx];
-            T100 = adc_to_T100(ADC_Get_Sample(6));
-            buf[idx] = T100;
-            sum += T100;
-            if(++idx >= MA_N) idx = 0;
-            T100_avg = (unsigned int)(sum / MA_N);
+        // New sample every SAMPLE_MS, taken by the interrupts
+        if(adc_ready){
+            adc_ready = 0;
+            filter_push(&smooth, adc_to_T100(adc_result));
+
+            // Show smoothed temperature
+            displayTemperature(filter_value(&smooth));
         }
 
-        // Show averaged temperature
-        displayTemperature(T100_avg);
+        // The rest of the CPU time is free for other work
+        HAL_IDLE();
     }
 }
+
+void main(void){
+    temperatureLoop();
+}
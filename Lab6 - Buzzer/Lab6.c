@@ -2,80 +2,97 @@
 // PIC18(L)F2X/4XK22 - Buzzer interfacing on RC2
 // Generates continuous tone, melody, multi-tone chime, and button-triggered note
 
-#include <xc.h>
+#include "hal.h"
+#include "tone.h"      // CCP1 drives RC2; see Commented/Tone.c
+#include "melody.h"
+#include "synth.h"     // CCP1 PWM chords; see Commented/Synth.c
+#include "debounce.h"
+#include "songs.h"     // SONG_MELODY, SONG_CHIME; edit songs.txt, not this
 
-#define BUZZER LATC2_bit  // Buzzer pin
-#define BUTTON RB0_bit    // Button input
+#define BUTTON 0x01          // RB0, debounced by Timer6
+#define BUTTON_CUTS_IN 0     // 1: a press stops the melody, 0: it waits its turn
 
 // ===================== Task 1: Continuous Tone =====================
-void playTone(unsigned int freq, unsigned int duration_ms){
-    unsigned long period_us = 1000000UL / freq;
-    unsigned long half_period = period_us / 2UL;
-    unsigned long cycles = ((unsigned long)duration_ms * 1000UL) / period_us;
-
-    for(unsigned long i = 0; i < cycles; i++){
-        BUZZER = 1;
-        Delay_us(half_period);
-        BUZZER = 0;
-        Delay_us(half_period);
-    }
-}
-
-void continuousTone(unsigned int freq){
+// Plays one note until reset; the CPU has nothing to do for it.
+void continuousTone(unsigned char note){
+    Tone_Play(note, 0);
     while(1){
-        playTone(freq, 10); // short chunks to keep MCU responsive
+        HAL_IDLE();
     }
 }
 
 // ===================== Task 2: Simple Melody =====================
-unsigned int melodyNotes[] = { 264, 264, 297, 264, 352, 330, 264, 264, 297, 264, 396, 352 };
-unsigned char melodyDurations[] = { 250, 250, 500, 500, 500, 1000, 250, 250, 500, 500, 500, 1000 };
-
+// Plays from the Timer2 interrupt; returns at once and
+// Melody_Playing() tells when it is over.
 void playMelody(void){
-    for(unsigned char i = 0; i < sizeof(melodyNotes)/sizeof(melodyNotes[0]); i++){
-        playTone(melodyNotes[i], melodyDurations[i]);
-        Delay_ms(50);
-    }
+    Synth_Stop();
+    Melody_Start(SONG_MELODY, 0);
 }
 
 // ===================== Task 3: Multi-Tone Chime =====================
-unsigned int chimeNotes[] = { 440, 554, 659 };
-unsigned char chimeDur[] = { 200, 200, 200 };
-
+// A4, C#5 and E5 struck together and fading out like a bell, mixed
+// by the Synth interrupt; returns at once, Synth_Busy() while it rings.
 void playChime(void){
-    for(unsigned char i = 0; i < sizeof(chimeNotes)/sizeof(chimeNotes[0]); i++){
-        playTone(chimeNotes[i], chimeDur[i]);
-        Delay_ms(50);
-    }
+    Melody_Stop();
+    Synth_Note(0, NOTE(A,4), SYNTH_LEVEL_MAX, 4);
+    Synth_Note(1, NOTE(CS,5), SYNTH_LEVEL_MAX, 4);
+    Synth_Note(2, NOTE(E,5), SYNTH_LEVEL_MAX, 4);
 }
 
-// ===================== Task 4: Play note on button press =====================
-// Press BUTTON to play a note of frequency `freq` for `duration_ms` milliseconds
-void playNoteOnButtonPress(unsigned int freq, unsigned int duration_ms){
-    static unsigned char prevButton = 1;
+// The chime one note after another, as a song
+void playChimeArpeggio(void){
+    Synth_Stop();
+    Melody_Start(SONG_CHIME, 0);
+}
 
-    if(prevButton == 1 && BUTTON == 0){ // detect falling edge
-        Delay_ms(30); // debounce
-        if(BUTTON == 0){
-            playTone(freq, duration_ms);
-        }
+// ===================== Task 4: Play note on button press =====================
+// Each debounced BUTTON press plays `note` for `duration_ms` milliseconds,
+// cutting into a running melody or queued behind it (BUTTON_CUTS_IN).
+// Returns at once.
+void playNoteOnButtonPress(unsigned char note, unsigned int duration_ms){
+    if(Debounce_Pressed(BUTTON)){
+        Synth_Stop();   // the buzzer goes back to single notes
+#if BUTTON_CUTS_IN
+        Melody_Stop();
+        Tone_Play(note, duration_ms);
+#else
+        Melody_Queue(note, duration_ms);
+#endif
     }
-    prevButton = BUTTON;
 }
 
 // ===================== Initialization =====================
 void initBuzzer(void){
-    TRISC2_bit = 0;  // RC2 output
-    BUZZER = 0;
-    ANSELC2_bit = 0;  // digital
+    Tone_Init();      // RC2 output, Timer1/CCP1 and the Timer2 tick
+    Synth_Init();     // CCP1 PWM on Timer2 while a chord plays
     TRISB0_bit = 1;   // button input
     ANSELB0_bit = 0;  // digital input
+    Debounce_Init(BUTTON);
+}
+
+// ===================== Interrupts =====================
+#ifndef LAB_LIBRARY   // the benchmarks link this file without its vector
+HAL_ISR(isr){
+    if(PIR1bits.CCP1IF) Tone_ISR_Handler();
+    if(PIR1bits.TMR2IF){   // Timer2 serves whichever owns the buzzer
+        if(Synth_Busy()) Synth_ISR_Handler();
+        else Melody_Tick_Handler();
+    }
+    if(PIR5bits.TMR6IF) Debounce_ISR_Handler();
 }
+#endif
 
-// ===================== Example main for button-triggered note =====================
+// ===================== Example main: melody with button-triggered note =====================
+// The button works while the melody plays; its note follows the melody.
 void buzzerMain(void){
     initBuzzer();
+    INTCONbits.GIE = 1;
+    playMelody();
     while(1){
-        playNoteOnButtonPress(440, 500); // A4 note, 500 ms
+        playNoteOnButtonPress(NOTE(A,4), 500); // A4 note, 500 ms
     }
 }
+
+void main(void){
+    buzzerMain();
+}
@@ -0,0 +1,15 @@
+// Generated by tools/songgen.py from songs.txt
+// Do not edit; rerun the generator instead.
+
+// 12 notes, 6.000 s
+static const unsigned char SONG_MELODY[28] = {
+    250,   0,  50,
+     60,   1,  60,   1,  62,   2,  60,   2,  65,   2,  64,   4,  60,   1,  60,   1,
+     62,   2,  60,   2,  67,   2,  65,   4, 255
+};
+
+// 3 notes, 0.750 s
+static const unsigned char SONG_CHIME[10] = {
+    250,   0,  50,
+     69,   1,  73,   1,  76,   1, 255
+};
@@ -1,46 +1,38 @@
 // lcd_driver_with_buttons.c
-#include <xc.h>
-#include <string.h>
-#include <stdio.h>
+#include "hal.h"
+#define _XTAL_FREQ 16000000UL
+#include "lcd.h"
+#include "fmt.h"
+#include "debounce.h"
+#include "power.h"
 
 //------------------------ LCD Functions ------------------------//
 
-void LCD_Init(void) {
-    ANSELD = 0; // Make PORTD digital (data lines)
-    TRISD = 0;  // RD0-RD7 as output
-    ANSELE = 0; TRISE0 = 0; TRISE1 = 0; // Control lines: RS=RE0, EN=RE1
-    // LCD initialization sequence goes here
-}
-
-void LCD_Command(unsigned char cmd) {
-    // Send command to LCD (RS=0)
-}
-
-void LCD_WriteChar(char c) {
-    // Send character to LCD (RS=1)
-}
+// The LCD is driven by the shared driver (Commented/LCD.c) over the
+// 8-bit PORTD bus: D0..D7 = RD0..RD7, RS = RE0, EN = RE1.
+#if !LCD_BUS_8BIT
+#error "The Lab7 board wires the LCD as an 8-bit bus; build with LCD_BUS_8BIT=1"
+#endif
 
+// Lines are numbered from 0 here, rows from 1 in the driver. Both
+// writers go through the driver's shadow, so only changed cells are sent.
 void LCD_WriteLine1(const char* str) {
-    LCD_SetCursor(0, 0);
-    for(unsigned char i=0; i<16 && str[i]!=0; i++)
-        LCD_WriteChar(str[i]);
+    LCD_Buf_Set_Cursor(1, 0);
+    LCD_Buf_String(str);
+    LCD_Flush();
 }
 
 void LCD_WriteMultiLine(const char* str) {
-    LCD_SetCursor(0, 0);
     unsigned char line = 0, col = 0;
     for(unsigned char i=0; str[i]!=0 && line<2; i++) {
-        if(col>=16) { line++; col=0; LCD_SetCursor(line, col); }
+        if(str[i]=='\n') { line++; col=0; continue; }
+        if(col>=16) { line++; col=0; }
         if(line>=2) break;
-        LCD_WriteChar(str[i]);
+        LCD_Buf_Set_Cursor(line + 1, col);
+        LCD_Buf_Char(str[i]);
         col++;
     }
-}
-
-void LCD_SetCursor(unsigned char line, unsigned char col) {
-    unsigned char addr = (line==0) ? 0x00 : 0x40;
-    addr += col;
-    LCD_Command(0x80 | addr);
+    LCD_Flush();
 }
 
 //------------------------ Button and LED ------------------------//
@@ -48,13 +40,13 @@ void LCD_SetCursor(unsigned char line, unsigned char col) {
 // Single button RB0 -> LED RB1
 void ButtonLED_Init(void) {
     ANSELB = 0x00;   // PORTB digital
-    TRISB0 = 1;      // RB0 input
-    TRISB1 = 0;      // RB1 output
-    LATB1 = 0;       // LED off
+    TRISBbits.TRISB0 = 1; // RB0 input
+    TRISBbits.TRISB1 = 0; // RB1 output
+    LATBbits.LATB1 = 0;   // LED off
 }
 
 void CheckButtonAndLED(void) {
-    RB1_bit = (RB0_bit == 0) ? 1 : 0;
+    LATBbits.LATB1 = (Debounce_Held() & 0x01) ? 1 : 0;
 }
 
 //------------------------ Multi-button LCD Display ------------------------//
@@ -65,28 +57,55 @@ void MultiButton_Init(void) {
     TRISB = 0xFF;        // All PORTB pins as inputs
 }
 
-// Read all PORTB buttons and display status on LCD
+// Read all PORTB buttons and display status on LCD (RB7 on the left)
 void DisplayButtonStates(void) {
-    char buf[17];
-    for(unsigned char i=0;i<8;i++){
-        buf[i] = (RB0_bit >> i & 0x01) ? '1' : '0'; // read bit i
-    }
-    buf[8] = 0; // null terminate string
+    char buf[9];
+    Fmt_Bin(buf, PORTB, 8); // sample all buttons at once
     LCD_WriteLine1(buf);
 }
 
 //------------------------ Example Main ------------------------//
 
+// Every PORTB input but RB3 (no interrupt) wakes the core;
+// RB1 is the LED
+#define BUTTONS   0xFD
+#define WAKE_PINS 0xF5
+
+// Timer4 drains the LCD queue, Timer6 debounces the buttons
+HAL_ISR(isr) {
+#if LCD_ASYNC
+    if (PIR5bits.TMR4IF)
+        LCD_ISR_Handler();
+#endif
+    if (PIR5bits.TMR6IF)
+        Debounce_ISR_Handler();
+    Power_ISR_Handler();
+}
+
+// Sleeps between button events. The LCD is only redrawn when a
+// button changed; while its queue drains the core idles, since
+// Timer4 stops in Sleep. RB3 shows on the next wake-up.
 void main(void) {
     LCD_Init();
-    ButtonLED_Init();
     MultiButton_Init();
+    ButtonLED_Init();         // after MultiButton_Init: RB1 stays an output
+    Debounce_Init(BUTTONS);
+    Power_Init(WAKE_PINS);
+    INTCONbits.GIE = 1;       // LCD output runs from the Timer4 interrupt
 
     LCD_WriteMultiLine("Buttons Demo\nPORTB Status");
+    DisplayButtonStates();
 
     while(1) {
-        CheckButtonAndLED();      // RB0 -> RB1 LED
-        DisplayButtonStates();    // Show all button states on LCD
-        __delay_ms(100);          // small delay for readability
+        if (Debounce_Pressed(BUTTONS) | Debounce_Released(BUTTONS)) {
+            CheckButtonAndLED();      // RB0 -> RB1 LED
+            DisplayButtonStates();    // Show all button states on LCD
+        }
+        LCD_Flush();                  // cells that did not fit in the queue yet
+#if LCD_ASYNC
+        Power_Sleep(LCD_Pending() != 0);
+#else
+        Power_Sleep(0);
+#endif
     }
 }
@@ -0,0 +1,33 @@
+// bench.h
+// Instruction-cycle measurement for the benchmark suite.
+//
+// On the target (and under gpsim) cycles come from Timer1 clocked at
+// Fosc/4 with a software overflow count.  Under the host simulator they
+// come from its virtual cycle clock.
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include "hal.h"
+
+enum {
+#define BENCH_ITEM(id) BENCH_##id,
+#include "bench_list.h"
+#undef BENCH_ITEM
+    BENCH_COUNT
+};
+
+extern volatile unsigned long bench_cycles[BENCH_COUNT];
+extern unsigned long bench_overhead;
+
+void bench_timer_init(void);
+unsigned long bench_now(void);
+
+// Run the statements once and store their cost in bench_cycles[BENCH_id]
+#define BENCH(id, ...) do { \
+    unsigned long bench_t0_ = bench_now(); \
+    __VA_ARGS__; \
+    bench_cycles[BENCH_##id] = bench_now() - bench_t0_ - bench_overhead; \
+} while (0)
+
+#endif // BENCH_H
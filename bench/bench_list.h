@@ -0,0 +1,53 @@
+// Hot paths measured by the benchmark suite, one BENCH_ITEM(id) per line.
+// The ids are the names used in the baseline files.
+BENCH_ITEM(sevenseg_isr)
+BENCH_ITEM(sevenseg_update)
+BENCH_ITEM(sevenseg_update_same)
+BENCH_ITEM(sevenseg_show_text)
+BENCH_ITEM(sevenseg_scroll_text)
+BENCH_ITEM(sevenseg_isr_scroll)
+BENCH_ITEM(split4)
+BENCH_ITEM(bin_to_bcd4)
+BENCH_ITEM(bcd4_divmod)
+BENCH_ITEM(adc_to_T100)
+BENCH_ITEM(cal_t100_os)
+BENCH_ITEM(lm35_read_temp)
+BENCH_ITEM(lm35_read_t100)
+BENCH_ITEM(adc_isr)
+BENCH_ITEM(adc_scan_isr)
+BENCH_ITEM(adc_get_sample)
+BENCH_ITEM(lcd_bus_write)
+BENCH_ITEM(lcd_cmd)
+BENCH_ITEM(lcd_string16)
+BENCH_ITEM(lcd_string16_shown)
+BENCH_ITEM(lcd_queue_isr)
+BENCH_ITEM(lcd_redraw_line)
+BENCH_ITEM(lcd_flush_static)
+BENCH_ITEM(lcd_flush_1cell)
+BENCH_ITEM(fmt_uint5)
+BENCH_ITEM(sprintf_uint5)
+BENCH_ITEM(fmt_t100)
+BENCH_ITEM(sprintf_t100)
+BENCH_ITEM(fmt_bin8)
+BENCH_ITEM(filter_boxcar8)
+BENCH_ITEM(filter_iir4)
+BENCH_ITEM(filter_median5)
+BENCH_ITEM(filter_hyst)
+BENCH_ITEM(tlog_add)
+BENCH_ITEM(tlog_isr)
+BENCH_ITEM(debounce_isr)
+BENCH_ITEM(power_edge_isr)
+BENCH_ITEM(tone_play)
+BENCH_ITEM(tone_isr)
+BENCH_ITEM(tone_stop)
+BENCH_ITEM(melody_start)
+BENCH_ITEM(melody_tick)
+BENCH_ITEM(melody_stop)
+BENCH_ITEM(synth_note)
+BENCH_ITEM(synth_isr)
+BENCH_ITEM(synth_stop)
+BENCH_ITEM(led_isr)
+BENCH_ITEM(led_play)
+BENCH_ITEM(led_levels)
+BENCH_ITEM(sched_tick)
+BENCH_ITEM(sched_run_once)
@@ -0,0 +1,627 @@
+// bench_main.c
+// Cycle-count benchmarks for the hot paths of the drivers and labs.
+//
+// Target build (XC8 + gpsim, see gpsim_bench.py): results are left in
+// bench_cycles[] and the program parks in bench_done() for the simulator
+// to dump them.
+// Host build (bench_host): results are printed and checked against a
+// baseline file; any entry slower than its baseline, or missing from
+// it, fails the run.
+
+#define _XTAL_FREQ 16000000UL
+#include "bench.h"
+#include "adc.h"
+#include "bcd.h"
+#include "calib.h"
+#include "debounce.h"
+#include "filter.h"
+#include "fmt.h"
+#include "lcd.h"
+#include "lm35.h"
+#include "power.h"
+#include "sched.h"
+#include "sevenseg.h"
+#include "melody.h"
+#include "synth.h"
+#include "templog.h"
+
+#include <stdio.h>                      // sprintf, for comparison only
+
+#ifdef HOST_SIM
+#include <stdlib.h>
+#include <string.h>
+#endif
+
+// Lab2 and Lab5 have no headers; they are linked with main renamed
+void split4(unsigned int v, unsigned char *u, unsigned char *t, unsigned char *h, unsigned char *th);
+unsigned int adc_to_T100(unsigned int adc);
+unsigned int ADC_Get_Sample(unsigned char ch);
+void ledInit(void);
+void ledISR(void);
+void ledSetLevels(const unsigned char *level);
+void Comet(void);
+
+// Digit split as it was done before bin_to_bcd4, kept for comparison
+// under bench-xc8 (both are compute only: the host times neither)
+static void bcd4_divmod(unsigned int v, unsigned char d[4]) {
+    d[0] = v / 1000;
+    d[1] = (v / 100) % 10;
+    d[2] = (v / 10) % 10;
+    d[3] = v % 10;
+}
+
+volatile unsigned long bench_cycles[BENCH_COUNT];
+unsigned long bench_overhead;
+
+// LCD enable pulses for the redraw / flush benchmarks
+static unsigned long lcd_pulses[3];
+
+// Timer4 interrupts taken by the LCD queue, and by LCD_Init + a line
+static volatile unsigned long lcd_irqs;
+static unsigned long lcd_irqs_init, lcd_irqs_line;
+
+// Set for power_report, so the other benchmarks' interrupts stay as lean
+static unsigned char bench_sleep_mode;
+
+// Set while a Tone benchmark has the buzzer running
+static unsigned char bench_tone_mode;
+
+// The task sched_run_once runs
+static void bench_task(void) {
+}
+
+// Melody_Playing() 3 ms after queueing a 0 ms note
+static unsigned char melody_zero_held;
+
+// LED brightnesses for led_levels
+static const unsigned char led_ramp[8] = { 0, 1, 3, 15, 63, 127, 200, 255 };
+static const unsigned char led_full[8] = { 255, 255, 255, 255, 255, 255, 255, 255 };
+
+// LATC on the first and the eighth slot after a mid-frame ledSetLevels
+static unsigned char led_first, led_eighth;
+
+// 1 ms steps, so the first tick moves on to the second note
+static const unsigned char bench_song[] = {
+    1, 0, 0, NOTE(A, 4), 1, NOTE(E, 5), 1, MELODY_END
+};
+
+// Conversions counted over one second of free-running sampling
+static unsigned long adc_per_second;
+
+// Filters measured: boxcar of 8, IIR 1/4, median of 5, hysteresis 50
+static const unsigned char filter_kind[4] = { FILTER_BOXCAR, FILTER_IIR, FILTER_MEDIAN, FILTER_HYST };
+static const unsigned char filter_param[4] = { 3, 2, 5, 50 };
+static filter_t flt[4];
+
+// LM35, a potentiometer on AN0 and the fixed voltage reference
+static const adc_scan_t adc_scan[3] = {
+    LM35_SCAN_ENTRY, { 0, 0, 50, 0 }, { 31, 1, 10, 0 }
+};
+
+// ------------------------------------------------------------
+// Cycle source
+// ------------------------------------------------------------
+#ifdef HOST_SIM
+
+void bench_timer_init(void) {
+    sim_set_time_limit_us(0);
+}
+
+unsigned long bench_now(void) {
+    return (unsigned long)sim_cycles();
+}
+
+#else
+
+static volatile unsigned int t1_overflows;
+
+void bench_timer_init(void) {
+    T1CON = 0x03;               // Fosc/4, 1:1, 16-bit reads, on
+    PIR1bits.TMR1IF = 0;
+    PIE1bits.TMR1IE = 1;
+    INTCONbits.PEIE = 1;
+    INTCONbits.GIE = 1;
+}
+
+unsigned long bench_now(void) {
+    unsigned int ovf;
+    unsigned char l, h;
+    do {
+        ovf = t1_overflows;
+        l = TMR1L;              // latches TMR1H
+        h = TMR1H;
+    } while (ovf != t1_overflows);
+    return ((unsigned long)ovf << 16) | ((unsigned int)h << 8) | l;
+}
+
+// gpsim breaks here and dumps bench_cycles[]
+void bench_done(void) {
+    while (1);
+}
+
+#endif
+
+HAL_ISR(bench_isr) {
+#ifndef HOST_SIM
+    if (PIR1bits.TMR1IF) {
+        PIR1bits.TMR1IF = 0;
+        t1_overflows++;
+    }
+#endif
+    if (PIR1bits.ADIF)
+        ADC_ISR_Handler();
+    if (PIR2bits.EEIF)
+        TempLog_ISR_Handler();
+    if (bench_tone_mode) {
+        if (PIR1bits.CCP1IF)
+            Tone_ISR_Handler();
+        if (PIR1bits.TMR2IF) {
+            if (Synth_Busy())
+                Synth_ISR_Handler();
+            else
+                Melody_Tick_Handler();
+        }
+    }
+    if (bench_sleep_mode) {             // only power_report takes these
+        if (PIR5bits.TMR6IF)
+            Debounce_ISR_Handler();
+        Power_ISR_Handler();
+    }
+#if LCD_ASYNC
+    if (PIR5bits.TMR4IF) {
+        LCD_ISR_Handler();
+        lcd_irqs++;
+    }
+#endif
+}
+
+// ------------------------------------------------------------
+// Benchmarks
+// ------------------------------------------------------------
+// LCD calls that only queue are followed by LCD_Wait_Idle() outside the
+// measurement so each benchmark starts with an empty queue.
+static void bench_run(void) {
+    unsigned char u, t, h, th, d[4], task;
+    volatile unsigned int sink = 1234;
+    volatile int t100 = 2345;           // volatile: not folded at compile time
+    char line[17];
+
+    bench_timer_init();
+    bench_overhead = 0;
+    BENCH(sevenseg_isr, (void)0);       // calibrate: empty measurement
+    bench_overhead = bench_cycles[BENCH_sevenseg_isr];
+
+    SevenSeg_Init();
+    INTCONbits.TMR0IE = 0;              // call the handler directly
+    INTCONbits.GIE = 1;
+    LCD_Init();
+    LCD_Wait_Idle();
+    lcd_irqs_init = lcd_irqs;
+    TRISCbits.TRISC2 = 0;               // buzzer output
+
+    BENCH(sevenseg_isr, SevenSeg_ISR_Handler());
+    BENCH(sevenseg_update, SevenSeg_Update_Value(1234));
+    BENCH(sevenseg_update_same, SevenSeg_Update_Value(1234));   // unchanged: early out
+    BENCH(sevenseg_show_text, SevenSeg_Show_Text("Err"));
+    BENCH(sevenseg_scroll_text, SevenSeg_Scroll_Text("LM35 TEMP 23.5*C", 50));
+    for (u = 0; u < 4; u++)
+        SevenSeg_ISR_Handler();             // ISR takes the mode change
+    BENCH(sevenseg_isr_scroll, SevenSeg_ISR_Handler());
+    BENCH(split4, split4(1234, &u, &t, &h, &th));
+    BENCH(bin_to_bcd4, bin_to_bcd4(sink, d));
+    BENCH(bcd4_divmod, bcd4_divmod(sink, d));
+    BENCH(adc_to_T100, sink = adc_to_T100(512));
+    BENCH(cal_t100_os, sink = cal_T100(sink, 2));   // 12-bit, interpolated
+
+    // Free-running ADC, only while its own benchmarks run
+    LM35_Init();
+    while (!ADC_Available())
+        HAL_IDLE();
+    BENCH(lm35_read_temp, sink = LM35_Read_Temp());
+    BENCH(lm35_read_t100, sink = LM35_Read_T100());
+    INTCONbits.GIE = 0;
+    while (!PIR1bits.ADIF);
+    BENCH(adc_isr, ADC_ISR_Handler());              // accumulate or queue
+    INTCONbits.GIE = 1;
+    adc_per_second = ADC_Sample_Count();
+    for (u = 0; u < 100; u++) {         // drained as fast as it fills
+        __delay_ms(10);
+        sink = LM35_Read_Temp();
+    }
+    adc_per_second = ADC_Sample_Count() - adc_per_second;
+    ADC_Scan_Start(adc_scan, 3);
+    INTCONbits.GIE = 0;
+    while (!PIR1bits.ADIF);
+    BENCH(adc_scan_isr, ADC_ISR_Handler());         // first tick: on to AN0
+    INTCONbits.GIE = 1;
+    ADC_Stop();
+    BENCH(adc_get_sample, sink = ADC_Get_Sample(LM35_CHANNEL));  // Lab5, blocking
+    LCD_RS = 0;                         // one transfer of "set address 0"
+#if LCD_BUS_8BIT
+    BENCH(lcd_bus_write, LCD_Bus_Write(0x80));
+#else
+    BENCH(lcd_bus_write, LCD_Bus_Write(0x08));
+    LCD_Bus_Write(0x00);                // keep the controller in nibble sync
+#endif
+    __delay_us(50);
+    BENCH(lcd_cmd, LCD_Cmd(0x80));
+    LCD_Wait_Idle();
+    BENCH(lcd_string16, LCD_String("0123456789ABCDEF"));
+    LCD_Wait_Idle();
+    lcd_irqs_line = lcd_irqs;
+    BENCH(lcd_string16_shown, LCD_Set_Cursor(1, 0); LCD_String("0123456789ABCDEF");
+          LCD_Wait_Idle());
+    lcd_irqs_line = lcd_irqs - lcd_irqs_line;
+#if LCD_ASYNC
+    LCD_Char('x');
+    INTCONbits.GIE = 0;
+    while (!PIR5bits.TMR4IF);
+    BENCH(lcd_queue_isr, LCD_ISR_Handler());    // one byte out
+    INTCONbits.GIE = 1;
+    LCD_Wait_Idle();
+#endif
+
+    // Status line redrawn in full vs. through the shadow buffer
+    lcd_pulses[0] = lcd_bus_transactions;
+    BENCH(lcd_redraw_line, LCD_Set_Cursor(2, 0); LCD_String("PORTB 00000000  "));
+    LCD_Wait_Idle();
+    lcd_pulses[0] = lcd_bus_transactions - lcd_pulses[0];
+    lcd_pulses[1] = lcd_bus_transactions;
+    BENCH(lcd_flush_static,
+          LCD_Buf_Set_Cursor(2, 0); LCD_Buf_String("PORTB 00000000  "); LCD_Flush());
+    LCD_Wait_Idle();
+    lcd_pulses[1] = lcd_bus_transactions - lcd_pulses[1];
+    lcd_pulses[2] = lcd_bus_transactions;
+    BENCH(lcd_flush_1cell,
+          LCD_Buf_Set_Cursor(2, 6); LCD_Buf_Char('1'); LCD_Flush());
+    LCD_Wait_Idle();
+    lcd_pulses[2] = lcd_bus_transactions - lcd_pulses[2];
+
+    // Formatting into an LCD line, stdio vs. fmt.c. Both are compute
+    // only, so the host times neither: the comparison is bench-xc8's
+    BENCH(fmt_uint5, Fmt_Uint(line, sink, 5));
+    BENCH(sprintf_uint5, sprintf(line, "%5u", sink));
+    BENCH(fmt_t100, Fmt_T100(line, t100, 3));
+    BENCH(sprintf_t100, sprintf(line, "%3d.%02dC", t100 / 100, t100 % 100));
+    BENCH(fmt_bin8, Fmt_Bin(line, 0xA5, 8));
+    // The filters are compute only: the host times none of them, and
+    // their cost against the old sum / MA_N is bench-xc8's to report
+    for (u = 0; u < 4; u++) {           // primed: steady-state cost
+        filter_init(&flt[u], filter_kind[u], filter_param[u]);
+        filter_push(&flt[u], t100);
+    }
+    BENCH(filter_boxcar8, filter_push(&flt[0], t100));
+    BENCH(filter_iir4, filter_push(&flt[1], t100));
+    BENCH(filter_median5, filter_push(&flt[2], t100));
+    BENCH(filter_hyst, filter_push(&flt[3], t100));
+
+    // EEPROM log: one delta queued and started, then the interrupt
+    // that retires it
+    TempLog_Init();
+    TempLog_Add(t100);
+    while (TempLog_Pending())
+        HAL_IDLE();
+    BENCH(tlog_add, TempLog_Add(t100 + 5));
+    INTCONbits.GIE = 0;
+    while (!PIR2bits.EEIF);
+    BENCH(tlog_isr, TempLog_ISR_Handler());
+    INTCONbits.GIE = 1;
+    while (TempLog_Pending())
+        HAL_IDLE();
+    Debounce_Init(0xFF);
+    PIE5bits.TMR6IE = 0;                // call the handler directly
+    BENCH(debounce_isr, Debounce_ISR_Handler());    // all 8 PORTB pins
+    T6CONbits.TMR6ON = 0;
+    Power_Init(0x01);
+    INTCONbits.GIE = 0;
+    INTCONbits.INT0IF = 1;
+    BENCH(power_edge_isr, Power_ISR_Handler());     // INT0 edge to debouncer
+    INTCONbits.INT0IE = 0;
+    PIE5bits.TMR5IE = 0;
+    T5CON = 0x00;
+    INTCONbits.GIE = 1;
+
+    // Tone: start, one edge rescheduled, stop
+    Tone_Init();
+    bench_tone_mode = 1;
+    BENCH(tone_play, Tone_Play(NOTE(A, 4), 100));
+    INTCONbits.GIE = 0;
+    while (!PIR1bits.CCP1IF);
+    BENCH(tone_isr, Tone_ISR_Handler());
+    INTCONbits.GIE = 1;
+    BENCH(tone_stop, Tone_Stop());
+
+    // Melody: start, the tick that ends a note and starts the next, stop
+    BENCH(melody_start, Melody_Start(bench_song, 0));
+    INTCONbits.GIE = 0;
+    while (!PIR1bits.TMR2IF);
+    BENCH(melody_tick, Melody_Tick_Handler());
+    INTCONbits.GIE = 1;
+    BENCH(melody_stop, Melody_Stop());
+    Melody_Queue(NOTE(A, 4), 0);        // taken as 1 ms, so it ends
+    __delay_ms(3);
+    melody_zero_held = Melody_Playing();
+
+    // Synth: a voice started, one sample mixed, all voices stopped
+    Synth_Init();
+    BENCH(synth_note, Synth_Note(0, NOTE(A, 4), SYNTH_LEVEL_MAX, 4));
+    Synth_Note(1, NOTE(CS, 5), SYNTH_LEVEL_MAX, 4);
+    Synth_Note(2, NOTE(E, 5), SYNTH_LEVEL_MAX, 4);
+    INTCONbits.GIE = 0;
+    while (!PIR1bits.TMR2IF);
+    BENCH(synth_isr, Synth_ISR_Handler());
+    INTCONbits.GIE = 1;
+    BENCH(synth_stop, Synth_Stop());
+    bench_tone_mode = 0;
+
+    // Lab2 LED engine: one bit-plane slot, a pattern started (its first
+    // step transposed into bit-planes), eight brightnesses set
+    ledInit();
+    T0CONbits.TMR0ON = 0;               // call the handler directly
+    INTCONbits.TMR0IE = 0;
+    BENCH(led_isr, ledISR());
+    BENCH(led_play, Comet());
+    BENCH(led_levels, ledSetLevels(led_ramp));
+    INTCONbits.TMR0IE = 0;
+    for (u = 0; u < 8; u++)             // a whole frame: the ramp shows
+        ledISR();
+    ledSetLevels(led_full);             // in slot 1, after led_isr's slot
+    ledISR();
+    led_first = LATC;
+    for (u = 1; u < 8; u++)
+        ledISR();
+    led_eighth = LATC;
+
+    // Scheduler: a tick walking a wheel slot of eight timers, one of
+    // them due and put back in, then the task it posted run and timed
+    Sched_Init();
+    T6CONbits.TMR6ON = 0;               // call the handler directly
+    task = Sched_Task(bench_task);
+    Sched_Every(task, 1);
+    for (u = 0; u < SCHED_TIMERS - 1; u++)
+        Sched_After(task, 17 + 16 * u);     // Same slot, not due
+    PIE5bits.TMR6IE = 0;
+    BENCH(sched_tick, Sched_ISR_Handler());
+    BENCH(sched_run_once, Sched_Run_Once());
+    (void)sink;
+}
+
+#ifdef HOST_SIM
+
+static const char *const bench_names[BENCH_COUNT] = {
+#define BENCH_ITEM(id) #id,
+#include "bench_list.h"
+#undef BENCH_ITEM
+};
+
+// Report checks: a figure outside its bound prints FAIL and fails the
+// run like a SLOWER benchmark.
+static int report_failures;
+
+static void expect(int ok, const char *what) {
+    if (!ok) {
+        printf("FAIL: %s\n", what);
+        report_failures++;
+    }
+}
+
+// Step 2000 -> 3000 and a single 9999 spike through each filter:
+// samples until the output is halfway / 90% of the way, and how far
+// the spike moves the output. The boxcar must settle exactly within
+// its window and the IIR within 9 samples, the medians must drop the
+// spike entirely, and the hysteresis must not chatter on +-1 LSB.
+static void filter_report(void) {
+    static const char *const names[4] = { "boxcar 8", "iir 1/4", "median 5", "hyst 50" };
+    static const unsigned char settle_max[4] = { 8, 9, 3, 1 };
+    unsigned int settled[4], spike[4];
+    for (int k = 0; k < 4; k++) {
+        filter_t f;
+        int half = -1, ninety = -1;
+        filter_init(&f, filter_kind[k], filter_param[k]);
+        filter_push(&f, 2000);
+        for (int n = 1; n <= 64; n++) {
+            filter_push(&f, 3000);
+            if (half < 0 && filter_value(&f) >= 2500) half = n;
+            if (ninety < 0 && filter_value(&f) >= 2900) ninety = n;
+        }
+        settled[k] = filter_value(&f);
+        filter_init(&f, filter_kind[k], filter_param[k]);
+        filter_push(&f, 2000);
+        filter_push(&f, 9999);
+        spike[k] = filter_value(&f) - 2000;
+        printf("Filter %-9s step 50%% after %d, 90%% after %d samples; spike +%u\n",
+               names[k], half, ninety, spike[k]);
+        expect(ninety > 0 && ninety <= settle_max[k], "filter step slower than its bound");
+    }
+    expect(settled[0] == 3000, "boxcar 8 not at the step after 64 samples");
+    expect(settled[1] >= 2997 && settled[1] <= 3000, "iir 1/4 not within 3 of the step");
+    expect(settled[2] == 3000 && settled[3] == 3000, "median / hysteresis not at the step");
+    expect(spike[0] <= 8000 / 8, "boxcar 8 passes more than 1/8 of a spike");
+    expect(spike[1] <= 8000 / 4, "iir 1/4 passes more than 1/4 of a spike");
+    expect(spike[2] == 0, "median 5 lets a 1-sample spike through");
+
+    // Median of 3 on its own, and +-1 LSB noise through the hysteresis
+    filter_t f;
+    filter_init(&f, FILTER_MEDIAN, 3);
+    filter_push(&f, 2000);
+    filter_push(&f, 2000);
+    filter_push(&f, 9999);
+    expect(filter_value(&f) == 2000, "median 3 lets a 1-sample spike through");
+    filter_push(&f, 2000);
+    expect(filter_value(&f) == 2000, "median 3 output moved after the spike");
+
+    unsigned int changes = 0, last;
+    filter_init(&f, FILTER_HYST, 50);
+    filter_push(&f, 2000);
+    last = filter_value(&f);
+    for (int n = 0; n < 64; n++) {
+        filter_push(&f, (n & 1) ? 2001 : 1999);
+        if (filter_value(&f) != last) changes++;
+        last = filter_value(&f);
+    }
+    printf("Filter hyst 50   %u output changes on 64 samples of +-1 LSB noise\n", changes);
+    expect(changes == 0, "hysteresis chatters on +-1 LSB noise");
+
+    // An out-of-range IIR param is clamped to 8, so full scale still
+    // fits the 32-bit state
+    filter_init(&f, FILTER_IIR, 40);
+    filter_push(&f, 65535u);
+    filter_push(&f, 65535u);
+    expect(f.param == 8 && filter_value(&f) == 65535u, "iir param not clamped to 8");
+}
+
+// A slow drift with an occasional jump, logged for two laps of the
+// EEPROM: samples kept and bytes written per sample. The deltas must
+// keep at least 200 samples in the 256 bytes, cost under 1.25 writes
+// per sample, drop none and read back exactly.
+static void tlog_report(void) {
+    unsigned int t = 2000, v, kept = 0, last = 0;
+    unsigned long writes = sim_eeprom_writes();
+    TempLog_Init();
+    for (int n = 0; n < 600; n++) {
+        t = (n % 50 == 49) ? t + 500 : t + (n % 7) - 3;
+        TempLog_Add(t);
+        while (TempLog_Pending())
+            HAL_IDLE();
+    }
+    writes = sim_eeprom_writes() - writes;
+    TempLog_Rewind();
+    while (TempLog_Next(&v)) {
+        kept++;
+        last = v;
+    }
+    printf("EEPROM log: %u samples kept in %d bytes, %lu.%02lu writes/sample, %u dropped\n",
+           kept, TLOG_BLOCK * TLOG_BLOCKS, writes / 600, writes * 100 / 600 % 100, tlog_dropped);
+    expect(kept >= 200, "EEPROM log keeps fewer than 200 samples");
+    expect(writes * 4 < 600 * 5, "EEPROM log writes 1.25 bytes or more per sample");
+    expect(tlog_dropped == 0, "EEPROM log dropped samples");
+    expect(last == t, "EEPROM log reads back a different newest sample");
+}
+
+// The Lab3 counter asleep between presses, on a fresh machine: ten
+// presses of RB0/RB1 that bounce for 1.2 ms each way, 200 ms apart.
+// Wake-ups, time awake and press-to-LED latency. Every press must be
+// counted once, within 1 ms, with the core awake under 1% of the time.
+static void power_report(void) {
+    uint64_t start, due[10];
+    unsigned long worst = 0;
+    unsigned char n, pressed = 0, released = 0, btn;
+
+    sim_reset();
+    ANSELB = 0x00;
+    TRISB = 0x03;
+    TRISC = 0x00;
+    LATC = 0x00;
+    sim_set_pins(SIM_PORTB, 0xFF);
+    start = sim_cycles();
+    for (n = 0; n < 10; n++) {
+        uint64_t t = 100000u + n * 200000u;
+        due[n] = start + t * SIM_TCY_PER_US;
+        for (btn = 0; btn < 5; btn++) {     // down, up, down ... and back
+            sim_set_pin_after(t + btn * 300u, SIM_PORTB, n & 1, btn & 1);
+            sim_set_pin_after(t + 80000u + btn * 300u, SIM_PORTB, n & 1, !(btn & 1));
+        }
+    }
+    Debounce_Init(0x03);
+    Power_Init(0x03);
+    bench_sleep_mode = 1;
+    INTCONbits.GIE = 1;
+    while (released < 10 || Debounce_Busy()) {
+        btn = Debounce_Pressed(0x03);
+        if (btn) {
+            LATC = ++pressed;
+            unsigned long lat = (unsigned long)(sim_cycles() - due[pressed - 1]) / SIM_TCY_PER_US;
+            if (lat > worst) worst = lat;
+        }
+        if (Debounce_Released(0x03))
+            released++;
+        Power_Sleep(0);
+    }
+    unsigned long total = (unsigned long)((sim_cycles() - start) / SIM_TCY_PER_US);
+    unsigned long active = Power_Active_Us();
+    printf("Sleep mode: %u presses counted, %lu wake-ups, awake %lu us of %lu ms (%lu.%02lu%%), "
+           "worst latency %lu us\n", pressed, Power_Wakes(), active, total / 1000,
+           active * 100 / total, active * 10000 / total % 100, worst);
+    expect(pressed == 10, "sleep mode missed or doubled a press");
+    expect(worst < 1000, "sleep mode press latency 1 ms or more");
+    expect(active * 100 < total, "sleep mode awake 1% of the time or more");
+}
+
+static long baseline_of(FILE *f, const char *name) {
+    char line[128], key[64];
+    unsigned long v;
+    if (!f) return -1;
+    rewind(f);
+    while (fgets(line, sizeof line, f)) {
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%63s %lu", key, &v) == 2 && strcmp(key, name) == 0)
+            return (long)v;
+    }
+    return -1;
+}
+
+// usage: bench_host [baseline.txt [--update]]
+int main(int argc, char **argv) {
+    const char *path = argc > 1 ? argv[1] : NULL;
+    int update = argc > 2 && strcmp(argv[2], "--update") == 0;
+    FILE *f = (path && !update) ? fopen(path, "r") : NULL;
+    int slower = 0;
+
+    bench_run();
+
+    printf("%-20s %10s %10s\n", "benchmark", "cycles", "baseline");
+    for (int i = 0; i < BENCH_COUNT; i++) {
+        long base = baseline_of(f, bench_names[i]);
+        const char *mark = "";
+        // No register traffic: the host has nothing to time, so the
+        // entry stays out of the baseline rather than gating on 0
+        if (bench_cycles[i] == 0 && base <= 0) {
+            printf("%-20s %10s %10s  not timed on host\n", bench_names[i], "-", "-");
+            continue;
+        }
+        if (base < 0 && f) { mark = "  MISSING"; slower = 1; }
+        else if (base >= 0 && (long)bench_cycles[i] > base) { mark = "  SLOWER"; slower = 1; }
+        else if (base >= 0 && (long)bench_cycles[i] < base) mark = "  faster";
+        printf("%-20s %10lu %10ld%s\n", bench_names[i], bench_cycles[i], base, mark);
+    }
+    if (f) fclose(f);
+    printf("LCD bus transactions: redraw_line %lu, flush_static %lu, flush_1cell %lu\n",
+           lcd_pulses[0], lcd_pulses[1], lcd_pulses[2]);
+    // lcd_string16_shown moves 17 bytes: the cursor command and 16 chars
+    printf("LCD throughput (%d-bit bus): %lu bytes/s\n", LCD_BUS_8BIT ? 8 : 4,
+           bench_cycles[BENCH_lcd_string16_shown] ?
+           17UL * (_XTAL_FREQ / 4) / bench_cycles[BENCH_lcd_string16_shown] : 0UL);
+#if LCD_ASYNC
+    printf("LCD queue interrupts: init %lu, 17-byte line %lu\n", lcd_irqs_init, lcd_irqs_line);
+#endif
+    expect(led_first != 0xFF && led_eighth == 0xFF,
+           "ledSetLevels swapped bit-planes before the next slot 0");
+    expect(!melody_zero_held, "Melody_Queue(note, 0) still playing after 3 ms");
+    filter_report();
+    printf("ADC engine: %u Hz programmed, %lu samples/s counted, %u dropped\n",
+           ADC_Rate_Hz(0), adc_per_second, ADC_Dropped());
+    tlog_report();
+    power_report();                     // resets the simulated chip: last
+
+    if (update && path) {
+        FILE *out = fopen(path, "w");
+        if (!out) { perror(path); return 2; }
+        fprintf(out, "# Host-simulator cycles per benchmark, %d-bit LCD bus%s (bench-update target)\n",
+                LCD_BUS_8BIT ? 8 : 4, LCD_ASYNC ? "" : ", blocking");
+        for (int i = 0; i < BENCH_COUNT; i++)
+            if (bench_cycles[i])
+                fprintf(out, "%s %lu\n", bench_names[i], bench_cycles[i]);
+        fclose(out);
+    }
+    return slower || report_failures;
+}
+
+#else
+
+void main(void) {
+    OSCCONbits.IRCF = 7;
+    bench_run();
+    bench_done();
+}
+
+#endif
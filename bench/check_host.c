@@ -0,0 +1,106 @@
+// check_host.c
+// Exhaustive host checks for the division-free number formatting.
+//
+// bin_to_bcd4 is compared with / and % for every value 0..9999 (and
+// the clamp above), Fmt_Uint / Fmt_Uint0 / Fmt_Int / Fmt_T100 with
+// snprintf for every 16-bit value at widths 1..6. The first mismatch
+// of each kind is printed and the exit status is 1, so the default
+// build fails.
+
+#include "bcd.h"
+#include "fmt.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static unsigned long failures;
+
+static void mismatch(const char *what, long v, unsigned int width,
+                     const char *got, const char *want) {
+    if (failures++ < 10)
+        printf("%s(%ld, %u): \"%s\", expected \"%s\"\n", what, v, width, got, want);
+}
+
+// Right-aligned in width, or width '*' when it does not fit
+static void expect_fit(char *want, const char *text, unsigned int width) {
+    if (strlen(text) > width) {
+        memset(want, '*', width);
+        want[width] = 0;
+    } else {
+        sprintf(want, "%*s", (int)width, text);
+    }
+}
+
+static void check_bcd(void) {
+    unsigned char d[4];
+
+    for (unsigned int v = 0; v <= 10100; v++) {
+        unsigned int c = v > 9999 ? 9999 : v;
+        bin_to_bcd4(v, d);
+        if (d[0] != c / 1000 || d[1] != c / 100 % 10 || d[2] != c / 10 % 10 || d[3] != c % 10) {
+            char got[5] = { '0' + d[0], '0' + d[1], '0' + d[2], '0' + d[3], 0 };
+            char want[8];
+            sprintf(want, "%04u", c);
+            mismatch("bin_to_bcd4", v, 4, got, want);
+        }
+    }
+    bin_to_bcd4(65535u, d);
+    if (d[0] != 9 || d[1] != 9 || d[2] != 9 || d[3] != 9)
+        mismatch("bin_to_bcd4", 65535, 4, "?", "9999");
+}
+
+static void check_fmt(void) {
+    char got[24], want[24], text[16];
+    char *end;
+
+    for (unsigned int width = 1; width <= 6; width++) {
+        for (long v = 0; v <= 65535; v++) {
+            sprintf(text, "%lu", (unsigned long)v);
+            end = Fmt_Uint(got, (unsigned int)v, (unsigned char)width);
+            expect_fit(want, text, width);
+            if (strcmp(got, want) || end != got + strlen(got))
+                mismatch("Fmt_Uint", v, width, got, want);
+
+            end = Fmt_Uint0(got, (unsigned int)v, (unsigned char)width);
+            if (strlen(text) > width)
+                expect_fit(want, text, width);
+            else
+                sprintf(want, "%0*lu", (int)width, (unsigned long)v);
+            if (strcmp(got, want) || end != got + strlen(got))
+                mismatch("Fmt_Uint0", v, width, got, want);
+        }
+
+        for (long v = -32768; v <= 32767; v++) {
+            sprintf(text, "%ld", v);
+            end = Fmt_Int(got, (int)v, (unsigned char)width);
+            expect_fit(want, text, width);
+            if (strcmp(got, want) || end != got + strlen(got))
+                mismatch("Fmt_Int", v, width, got, want);
+
+            // Whole degrees (signed, "-0" below zero) in width, then
+            // ".hhC"; width + 4 '*' when the whole part does not fit
+            unsigned long a = v < 0 ? (unsigned long)-v : (unsigned long)v;
+            sprintf(text, "%s%lu", v < 0 ? "-" : "", a / 100);
+            if (strlen(text) > width) {
+                memset(want, '*', width + 4);
+                want[width + 4] = 0;
+            } else {
+                sprintf(want, "%*s.%02luC", (int)width, text, a % 100);
+            }
+            end = Fmt_T100(got, (int)v, (unsigned char)width);
+            if (strcmp(got, want) || end != got + strlen(got))
+                mismatch("Fmt_T100", v, width, got, want);
+        }
+    }
+}
+
+int main(void) {
+    check_bcd();
+    check_fmt();
+    if (failures) {
+        printf("check_host: %lu mismatches\n", failures);
+        return 1;
+    }
+    printf("check_host: bin_to_bcd4 and Fmt_* match / %% and snprintf\n");
+    return 0;
+}
@@ -0,0 +1,160 @@
+#!/usr/bin/env python3
+"""Build the benchmark firmware with XC8, run it under gpsim and compare
+the per-benchmark instruction cycles with bench/baseline_xc8.txt.
+
+The firmware (bench_main.c) times each hot path with Timer1 on Fosc/4 and
+stores the results in bench_cycles[]; it then parks in bench_done().  We
+break there, dump file registers and read the array back using the
+address from the XC8 map file.
+
+Exit status is 1 when any benchmark is slower than its baseline entry
+or has no entry at all (including a missing baseline file), so a new
+benchmark cannot pass unchecked. Run with --update to rewrite the
+baseline from the current build, and with -D NAME=VALUE to build a
+variant (e.g. -D LCD_BUS_8BIT=1).
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+CPU = "18F45K22"
+
+# (source, extra defines)
+SOURCES = [
+    ("bench/bench_main.c", []),
+    ("Commented/LCD.c", []),
+    ("Commented/fmt.c", []),
+    ("Commented/bcd.c", []),
+    ("Commented/Debounce.c", []),
+    ("Commented/calib.c", []),
+    ("Commented/filter.c", []),
+    ("Commented/ADC.c", []),
+    ("Commented/LM35.c", []),
+    ("Commented/Melody.c", []),
+    ("Commented/Power.c", []),
+    ("Commented/Sched.c", []),
+    ("Commented/SevenSeg.c", []),
+    ("Commented/Synth.c", []),
+    ("Commented/TempLog.c", []),
+    ("Commented/Tone.c", []),
+    ("Lab2 - LED/Lab2.c", ["-Dmain=lab2_main", "-DLAB_LIBRARY"]),
+    ("Lab5 - Temp/Lab5.c", ["-Dmain=lab5_main", "-DLAB_LIBRARY"]),
+    ("Lab6 - Buzzer/Lab6.c", ["-Dmain=lab6_main", "-DLAB_LIBRARY"]),
+    ("HAL/hal.c", []),
+]
+
+
+def bench_names():
+    with open(os.path.join(ROOT, "bench", "bench_list.h")) as f:
+        return re.findall(r"^BENCH_ITEM\((\w+)\)", f.read(), re.M)
+
+
+def run(cmd, **kw):
+    print(" ".join(cmd))
+    return subprocess.run(cmd, check=True, **kw)
+
+
+def build(xc8, out, defines):
+    os.makedirs(out, exist_ok=True)
+    flags = ["-mcpu=" + CPU, "-O2", "-std=c99",
+             "-I", os.path.join(ROOT, "HAL"),
+             "-I", os.path.join(ROOT, "Commented"),
+             "-I", os.path.join(ROOT, "bench")] + ["-D" + d for d in defines]
+    objs = []
+    for src, defs in SOURCES:
+        obj = os.path.join(out, os.path.splitext(os.path.basename(src))[0] + ".p1")
+        run([xc8] + flags + defs + ["-c", os.path.join(ROOT, src), "-o", obj])
+        objs.append(obj)
+    hexfile = os.path.join(out, "bench.hex")
+    mapfile = os.path.join(out, "bench.map")
+    out = run([xc8, "-mcpu=" + CPU] + objs + ["-o", hexfile, "-Wl,-Map=" + mapfile],
+              capture_output=True, text=True).stdout
+    # Flash use from the linker's memory summary
+    for line in out.splitlines():
+        if "Program space" in line:
+            print(line.strip())
+    return hexfile, mapfile
+
+
+def symbol(mapfile, name):
+    with open(mapfile) as f:
+        m = re.search(r"^\s*_%s\s+\S+\s+([0-9A-Fa-f]+)" % name, f.read(), re.M)
+    if not m:
+        sys.exit("symbol _%s not found in %s" % (name, mapfile))
+    return int(m.group(1), 16)
+
+
+def simulate(gpsim, hexfile, mapfile, count):
+    done = symbol(mapfile, "bench_done")
+    cycles = symbol(mapfile, "bench_cycles")
+    script = os.path.join(os.path.dirname(hexfile), "bench.stc")
+    with open(script, "w") as f:
+        f.write("break e 0x%x\nrun\ndump r\nquit\n" % done)
+    out = run([gpsim, "-i", "-p", "p" + CPU.lower(), "-c", script, hexfile],
+              capture_output=True, text=True).stdout
+
+    ram = {}
+    for m in re.finditer(r"^([0-9a-fA-F]+):\s+((?:[0-9a-fA-F]{2}\s+)+)", out, re.M):
+        base = int(m.group(1), 16)
+        for i, b in enumerate(m.group(2).split()):
+            ram[base + i] = int(b, 16)
+
+    def u32(addr):
+        return sum(ram.get(addr + i, 0) << (8 * i) for i in range(4))
+
+    return [u32(cycles + 4 * i) for i in range(count)]
+
+
+def load_baseline(path):
+    base = {}
+    if os.path.exists(path):
+        with open(path) as f:
+            for line in f:
+                parts = line.split()
+                if len(parts) >= 2 and not parts[0].startswith("#"):
+                    base[parts[0]] = int(parts[1])
+    return base
+
+
+def main():
+    ap = argparse.ArgumentParser()
+    ap.add_argument("--xc8", default="xc8-cc")
+    ap.add_argument("--gpsim", default="gpsim")
+    ap.add_argument("--build-dir", default=os.path.join(ROOT, "_bench_xc8"))
+    ap.add_argument("--baseline", default=os.path.join(ROOT, "bench", "baseline_xc8.txt"))
+    ap.add_argument("--update", action="store_true")
+    ap.add_argument("-D", dest="defines", action="append", default=[])
+    args = ap.parse_args()
+
+    names = bench_names()
+    hexfile, mapfile = build(args.xc8, args.build_dir, args.defines)
+    results = simulate(args.gpsim, hexfile, mapfile, len(names))
+    base = load_baseline(args.baseline)
+
+    slower = False
+    print("%-20s %10s %10s" % ("benchmark", "cycles", "baseline"))
+    for name, cyc in zip(names, results):
+        ref = base.get(name, -1)
+        mark = ""
+        if ref < 0 and not args.update:
+            mark, slower = "  MISSING", True
+        elif ref >= 0 and cyc > ref:
+            mark, slower = "  SLOWER", True
+        elif ref >= 0 and cyc < ref:
+            mark = "  faster"
+        print("%-20s %10d %10d%s" % (name, cyc, ref, mark))
+
+    if args.update:
+        with open(args.baseline, "w") as f:
+            f.write("# XC8 -O2 + gpsim instruction cycles per benchmark (gpsim_bench.py --update)\n")
+            for name, cyc in zip(names, results):
+                f.write("%s %d\n" % (name, cyc))
+    return 1 if slower else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
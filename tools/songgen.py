@@ -0,0 +1,152 @@
+#!/usr/bin/env python3
+"""Convert songs in text notation to the Melody byte format (melody.h).
+
+Each song starts with a header line, followed by its notes on any
+number of lines; lines starting with '#' are comments:
+
+    song MELODY step=250 gap=50
+    C4:1 C4 D4:2 C4:2 F4:2 E4:4
+    R:2 A#3 Bb3:2
+
+    songgen.py songs.txt -o songs.h
+
+step is the tempo, the length of one step in ms; gap is the silence in
+ms cut from the end of each note so repeated notes stay apart.  A note
+is a letter A..G, an optional # or b, and the octave (A4 = 440 Hz), or
+R for a rest, with an optional :STEPS length (1..255, default 1).
+
+Each song becomes "static const unsigned char SONG_<name>[]" in the
+header, so it stays in flash.
+"""
+
+import argparse
+import re
+import sys
+
+TONE_FIRST = 45         # NOTE(A, 2), as in tone.h
+TONE_LAST = 108         # NOTE(C, 8)
+TONE_REST = 0
+MELODY_END = 0xFF
+
+PITCH = {"C": 0, "D": 2, "E": 4, "F": 5, "G": 7, "A": 9, "B": 11}
+NOTE_RE = re.compile(r"^(?:([A-G])([#b]?)(-?\d)|R)(?::(\d+))?$")
+
+
+class SongError(Exception):
+    pass
+
+
+def parse_note(token):
+    m = NOTE_RE.match(token)
+    if not m:
+        raise SongError("bad note %r" % token)
+    letter, accidental, octave, steps = m.groups()
+    steps = int(steps) if steps else 1
+    if not 1 <= steps <= 255:
+        raise SongError("%r: length must be 1..255 steps" % token)
+    if letter is None:
+        return TONE_REST, steps
+    note = (int(octave) + 1) * 12 + PITCH[letter]
+    note += {"#": 1, "b": -1, "": 0}[accidental]
+    if not TONE_FIRST <= note <= TONE_LAST:
+        raise SongError("%r is outside A2..C8" % token)
+    return note, steps
+
+
+def parse_header(words):
+    if len(words) < 2 or not re.match(r"^[A-Za-z_]\w*$", words[1]):
+        raise SongError("expected 'song NAME step=MS [gap=MS]'")
+    opts = {"step": None, "gap": 0}
+    for w in words[2:]:
+        key, _, value = w.partition("=")
+        if key not in opts or not value.isdigit():
+            raise SongError("bad option %r" % w)
+        opts[key] = int(value)
+    if not opts["step"] or opts["step"] > 65535:
+        raise SongError("step must be 1..65535 ms")
+    if opts["gap"] > 255:
+        raise SongError("gap must be 0..255 ms")
+    return words[1].upper(), opts["step"], opts["gap"]
+
+
+def parse(lines):
+    """List of (name, step, gap, [(note, steps), ...])."""
+    songs = []
+    for num, line in enumerate(lines, 1):
+        words = line.split()
+        if not words or words[0].startswith("#"):
+            continue
+        try:
+            if words[0] == "song":
+                songs.append(parse_header(words) + ([],))
+                continue
+            if not songs:
+                raise SongError("notes before the first 'song' line")
+            name, step, gap, notes = songs[-1]
+            for w in words:
+                note, steps = parse_note(w)
+                if step * steps > 65535:
+                    raise SongError("%r lasts longer than 65535 ms" % w)
+                if step * steps <= gap:
+                    raise SongError("%r is no longer than the gap" % w)
+                notes.append((note, steps))
+        except SongError as e:
+            raise SongError("line %d: %s" % (num, e))
+    names = [s[0] for s in songs]
+    if len(set(names)) != len(names):
+        raise SongError("two songs share a name")
+    for name, _, _, notes in songs:
+        if not notes:
+            raise SongError("song %s has no notes" % name)
+    return songs
+
+
+def encode(step, gap, notes):
+    data = [step & 0xFF, step >> 8, gap]
+    for note, steps in notes:
+        data += [note, steps]
+    return data + [MELODY_END]
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[0])
+    ap.add_argument("input", help="song text file")
+    ap.add_argument("-o", "--output", help="header to write (default: stdout)")
+    args = ap.parse_args()
+
+    with open(args.input) as f:
+        try:
+            songs = parse(f)
+        except SongError as e:
+            sys.exit("songgen: %s: %s" % (args.input, e))
+
+    lines = [
+        "// Generated by tools/songgen.py from %s" % args.input.split("/")[-1],
+        "// Do not edit; rerun the generator instead.",
+    ]
+    for name, step, gap, notes in songs:
+        data = encode(step, gap, notes)
+        total = sum(s for _, s in notes) * step
+        lines += [
+            "",
+            "// %d notes, %d.%03d s" % (len(notes), total // 1000, total % 1000),
+            "static const unsigned char SONG_%s[%d] = {" % (name, len(data)),
+            "    %3d, %3d, %3d," % tuple(data[:3]),
+        ]
+        body = data[3:]
+        for i in range(0, len(body), 16):
+            row = ", ".join("%3d" % v for v in body[i:i + 16])
+            lines.append("    " + row + ("," if i + 16 < len(body) else ""))
+        lines.append("};")
+    text = "\n".join(lines) + "\n"
+
+    if args.output:
+        with open(args.output, "w") as out:
+            out.write(text)
+    else:
+        sys.stdout.write(text)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
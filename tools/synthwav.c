@@ -0,0 +1,101 @@
+// synthwav.c
+// Host build only: runs Lab6's chime (or melody) on the simulator and
+// writes what RC2 puts out to an 8-bit mono WAV file, so the buzzer
+// output can be listened to and looked at without a board.
+//
+//   synthwav chime.wav           the Synth chord
+//   synthwav melody.wav melody   the Tone/Melody song
+//
+// The PWM is recorded as its duty (see sim_buzzer_level), which is
+// what the buzzer's own inertia averages it to.
+
+#include <stdio.h>
+#include <string.h>
+#include "hal.h"
+#include "melody.h"
+#include "synth.h"
+
+#define WAV_RATE  15625                   // 256 Tcy per sample
+#define WAV_MAX_S 30
+
+// Lab6, linked with its main renamed
+void initBuzzer(void);
+void playMelody(void);
+void playChime(void);
+
+static void isr(void) {
+    if (PIR1bits.CCP1IF)
+        Tone_ISR_Handler();
+    if (PIR1bits.TMR2IF) {
+        if (Synth_Busy())
+            Synth_ISR_Handler();
+        else
+            Melody_Tick_Handler();
+    }
+}
+
+static void put_le(FILE *f, unsigned long v, int bytes) {
+    while (bytes--) {
+        fputc((int)(v & 0xFF), f);
+        v >>= 8;
+    }
+}
+
+static void wav_header(FILE *f, unsigned long samples) {
+    fwrite("RIFF", 1, 4, f);
+    put_le(f, 36 + samples, 4);
+    fwrite("WAVEfmt ", 1, 8, f);
+    put_le(f, 16, 4);                     // PCM format chunk
+    put_le(f, 1, 2);
+    put_le(f, 1, 2);                      // mono
+    put_le(f, WAV_RATE, 4);
+    put_le(f, WAV_RATE, 4);               // bytes per second
+    put_le(f, 1, 2);
+    put_le(f, 8, 2);
+    fwrite("data", 1, 4, f);
+    put_le(f, samples, 4);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2 || (argc > 2 && strcmp(argv[2], "melody"))) {
+        fprintf(stderr, "usage: synthwav OUT.wav [melody]\n");
+        return 2;
+    }
+    int melody = argc > 2;
+    FILE *f = fopen(argv[1], "wb");
+    if (!f) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    sim_reset();
+    sim_set_time_limit_us(0);
+    sim_set_isr(isr);
+    initBuzzer();
+    INTCONbits.GIE = 1;
+    if (melody)
+        playMelody();
+    else
+        playChime();
+
+    // Sampled against the cycle count: the interrupts' own cycles come
+    // on top of a delay's.
+    wav_header(f, 0);
+    uint64_t start = sim_cycles();
+    unsigned long n = 0;
+    while (n < (unsigned long)WAV_RATE * WAV_MAX_S) {
+        if (melody ? !Melody_Playing() && !Tone_Busy() : !Synth_Busy())
+            break;
+        uint64_t due = start + (uint64_t)(n + 1) * (SIM_FOSC / 4 / WAV_RATE);
+        if (sim_cycles() < due)
+            sim_delay_cycles((unsigned long)(due - sim_cycles()));
+        fputc(sim_buzzer_level(), f);
+        n++;
+    }
+    rewind(f);
+    wav_header(f, n);
+    fclose(f);
+    printf("%s: %lu samples, %lu.%03lu s at %u Hz\n", argv[1], n,
+           n / WAV_RATE, n % WAV_RATE * 1000 / WAV_RATE, WAV_RATE);
+    return 0;
+}